@@ -1,4 +1,4 @@
-QT += core gui network
+QT += core gui network concurrent
 greaterThan(QT_MAJOR_VERSION, 5): QT += widgets
 
 CONFIG += c++17
@@ -9,8 +9,30 @@ INCLUDEPATH += \
     src/Utils
 
 SOURCES += \
+    src/DataTypes/command.cpp \
+    src/DataTypes/configfile.cpp \
+    src/DataTypes/devicemetadatacache.cpp \
+    src/DataTypes/deviceregistry.cpp \
+    src/DataTypes/devicesettingsstore.cpp \
+    src/DataTypes/devicestore.cpp \
+    src/UI/equalizersliders.cpp \
+    src/UI/presetlibrarywindow.cpp \
     src/UI/settingswindow.cpp \
+    src/Utils/equalizerfit.cpp \
+    src/Utils/faketransport.cpp \
     src/Utils/headsetcontrolapi.cpp \
+    src/Utils/headsetcontrolparser.cpp \
+    src/Utils/headsetcontrolstream.cpp \
+    src/Utils/headsettransport.cpp \
+    src/Utils/hotplugmonitor.cpp \
+    src/Utils/inputreportlistener.cpp \
+    src/Utils/pollscheduler.cpp \
+    src/Utils/presetlibrary.cpp \
+    src/Utils/processsupervisor.cpp \
+    src/Utils/startuptimeline.cpp \
+    src/Utils/stylemanager.cpp \
+    src/Utils/subprocesstransport.cpp \
+    src/Utils/updatechecker.cpp \
     src/main.cpp \
     src/DataTypes/device.cpp \
     src/DataTypes/settings.cpp \
@@ -20,25 +42,62 @@ SOURCES += \
     src/Utils/utils.cpp
 
 HEADERS += \
+    src/DataTypes/command.h \
+    src/DataTypes/configfile.h \
+    src/DataTypes/devicemetadatacache.h \
+    src/DataTypes/deviceregistry.h \
+    src/DataTypes/devicesettingsstore.h \
+    src/DataTypes/devicestore.h \
     src/DataTypes/device.h \
     src/DataTypes/settings.h \
     src/UI/dialoginfo.h \
+    src/UI/equalizersliders.h \
     src/UI/loaddevicewindow.h \
     src/UI/mainwindow.h \
+    src/UI/presetlibrarywindow.h \
     src/UI/settingswindow.h \
+    src/Utils/equalizerfit.h \
+    src/Utils/faketransport.h \
     src/Utils/headsetcontrolapi.h \
+    src/Utils/headsetcontrolparser.h \
+    src/Utils/headsetcontrolstream.h \
+    src/Utils/headsettransport.h \
+    src/Utils/hotplugmonitor.h \
+    src/Utils/inputreportlistener.h \
+    src/Utils/pollscheduler.h \
+    src/Utils/presetlibrary.h \
+    src/Utils/processsupervisor.h \
+    src/Utils/snapshotpublisher.h \
+    src/Utils/startuptimeline.h \
+    src/Utils/stylemanager.h \
+    src/Utils/subprocesstransport.h \
+    src/Utils/updatechecker.h \
     src/Utils/utils.h
 
 FORMS += \
     src/UI/dialoginfo.ui \
     src/UI/loaddevicewindow.ui \
     src/UI/mainwindow.ui \
+    src/UI/presetlibrarywindow.ui \
     src/UI/settingswindow.ui
 
 TRANSLATIONS += \
     src/Resources/tr/HeadsetControl_GUI_en.ts \
     src/Resources/tr/HeadsetControl_GUI_it.ts
 
+# Enumeration cache on top of hidapi: qmake CONFIG+=hidapi
+hidapi {
+    DEFINES += HEADSETCONTROL_HIDAPI
+    SOURCES += src/Utils/attachmentcachetransport.cpp
+    HEADERS += src/Utils/attachmentcachetransport.h
+    unix {
+        CONFIG += link_pkgconfig
+        PKGCONFIG += hidapi-hidraw
+    } else {
+        LIBS += -lhidapi
+    }
+}
+
 RESOURCES += \
     src/Resources/icons.qrc
 
@@ -0,0 +1,12 @@
+#include "command.h"
+
+Command::Command(const QString &capability,
+                 const QString &flag,
+                 const QString &argument,
+                 const QVariant &value)
+{
+    this->capability = capability;
+    this->flag = flag;
+    this->argument = argument;
+    this->value = value;
+}
@@ -0,0 +1,31 @@
+#ifndef COMMAND_H
+#define COMMAND_H
+
+#include <QString>
+#include <QVariant>
+
+class Action
+{
+public:
+    bool success = false;
+    QString capability;
+    QString device;
+    QString status;
+    QString error_message;
+};
+
+class Command
+{
+public:
+    Command(const QString &capability,
+            const QString &flag,
+            const QString &argument,
+            const QVariant &value);
+
+    QString capability;
+    QString flag;
+    QString argument;
+    QVariant value;
+};
+
+#endif // COMMAND_H
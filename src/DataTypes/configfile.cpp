@@ -0,0 +1,107 @@
+#include "configfile.h"
+
+#include <QCborMap>
+#include <QDebug>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+
+ConfigFile::ConfigFile(const QString &jsonPath, Migration migration)
+    : jsonPath(jsonPath)
+    , migration(migration)
+{
+    cborPath = jsonPath;
+    if (cborPath.endsWith(".json")) {
+        cborPath.chop(5);
+    }
+    cborPath += ".cbor";
+}
+
+QString ConfigFile::getJsonPath() const
+{
+    return jsonPath;
+}
+
+QString ConfigFile::getCborPath() const
+{
+    return cborPath;
+}
+
+ConfigFile::Format ConfigFile::existingFormat() const
+{
+    return QFile::exists(cborPath) ? Cbor : Json;
+}
+
+QCborValue ConfigFile::read() const
+{
+    Format format = existingFormat();
+    QFile file(format == Cbor ? cborPath : jsonPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QCborValue();
+    }
+    QByteArray bytes = file.readAll();
+    file.close();
+
+    QCborValue root;
+    if (format == Cbor) {
+        QCborParserError error;
+        root = QCborValue::fromCbor(bytes, &error);
+        if (error.error != QCborError::NoError) {
+            qWarning() << "Couldn't parse" << cborPath << ":" << error.errorString();
+            return QCborValue();
+        }
+    } else {
+        QJsonParseError error;
+        QJsonDocument doc = QJsonDocument::fromJson(bytes, &error);
+        if (error.error != QJsonParseError::NoError) {
+            qWarning() << "Couldn't parse" << jsonPath << ":" << error.errorString();
+            return QCborValue();
+        }
+        root = doc.isArray() ? QCborValue::fromJsonValue(doc.array())
+                             : QCborValue::fromJsonValue(doc.object());
+    }
+
+    int schema = 0;
+    QCborValue data = root;
+    if (root.isMap() && root.toMap().contains(QStringLiteral("schema"))) {
+        schema = root["schema"].toInteger();
+        data = root["data"];
+    }
+    if (schema > SCHEMA_VERSION) {
+        qWarning() << "Configuration written by a newer version, schema" << schema;
+    }
+    if (schema < SCHEMA_VERSION && migration != nullptr) {
+        return migration(data, schema);
+    }
+    return data;
+}
+
+bool ConfigFile::write(const QCborValue &data, Format format) const
+{
+    QCborMap root;
+    root[QStringLiteral("schema")] = SCHEMA_VERSION;
+    root[QStringLiteral("data")] = data;
+
+    const QString &path = format == Cbor ? cborPath : jsonPath;
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Couldn't open" << path << "for writing";
+        return false;
+    }
+    if (format == Cbor) {
+        file.write(root.toCborValue().toCbor());
+    } else {
+        file.write(QJsonDocument(root.toJsonObject()).toJson());
+    }
+    // The old file is only replaced once the new one is completely written
+    if (!file.commit()) {
+        qWarning() << "Couldn't save" << path;
+        return false;
+    }
+
+    // Leave a single copy behind so reading never picks a stale one
+    QFile::remove(format == Cbor ? jsonPath : cborPath);
+    return true;
+}
@@ -0,0 +1,40 @@
+#ifndef CONFIGFILE_H
+#define CONFIGFILE_H
+
+#include <QCborValue>
+#include <QString>
+
+// A configuration file kept either as human readable JSON or as compact CBOR
+// next to it (same name, .cbor suffix). Both carry the same versioned envelope,
+// {"schema": N, "data": ...}; files written before the envelope existed are
+// read as schema 0. Older data is passed through the owner's Migration on load.
+class ConfigFile
+{
+public:
+    enum Format { Json, Cbor };
+
+    static constexpr int SCHEMA_VERSION = 1;
+
+    // Returns data written with an older schema converted to SCHEMA_VERSION
+    using Migration = QCborValue (*)(const QCborValue &data, int schema);
+
+    explicit ConfigFile(const QString &jsonPath, Migration migration = nullptr);
+
+    QString getJsonPath() const;
+    QString getCborPath() const;
+
+    // The format found on disk, CBOR winning when both exist; Json if there is none
+    Format existingFormat() const;
+
+    // Returns the data migrated to SCHEMA_VERSION, or an undefined value if nothing could be read
+    QCborValue read() const;
+    // Replaces the file atomically and removes the copy in the other format
+    bool write(const QCborValue &data, Format format) const;
+
+private:
+    QString jsonPath;
+    QString cborPath;
+    Migration migration;
+};
+
+#endif // CONFIGFILE_H
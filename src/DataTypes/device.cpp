@@ -1,10 +1,12 @@
 #include "device.h"
+#include "configfile.h"
+#include "deviceregistry.h"
 
-#include <QFile>
+#include <QCborArray>
+#include <QCborMap>
+#include <QDebug>
 #include <QJsonArray>
-#include <QJsonDocument>
 #include <QJsonObject>
-#include <QProcess>
 
 Battery::Battery() {}
 
@@ -25,94 +27,131 @@ Equalizer::Equalizer(int bands, int baseline, double step, int min, int max)
     band_max = max;
 }
 
-Device::Device() {}
+DeviceKey::DeviceKey() {}
+
+DeviceKey::DeviceKey(quint32 id, const QString &unit)
+    : id(id)
+    , unit(unit)
+{}
 
-Device::Device(const QJsonObject &jsonObj, QString jsonData)
+quint16 DeviceKey::parseId(const QString &id)
 {
-    status = jsonObj["status"].toString();
+    QStringView digits(id);
+    if (digits.startsWith(QLatin1String("0x"), Qt::CaseInsensitive)) {
+        digits = digits.mid(2);
+    }
+    bool ok = false;
+    quint16 value = digits.toUShort(&ok, 16);
+    return ok ? value : 0;
+}
 
-    device = jsonObj["device"].toString();
-    vendor = jsonObj["vendor"].toString();
-    product = jsonObj["product"].toString();
-    id_vendor = jsonObj["id_vendor"].toString();
-    id_product = jsonObj["id_product"].toString();
+quint32 DeviceKey::packId(const QString &id_vendor, const QString &id_product)
+{
+    return quint32(parseId(id_vendor)) << 16 | parseId(id_product);
+}
 
-    QJsonArray caps = jsonObj["capabilities"].toArray();
-    for (const QJsonValue &value : caps) {
-        capabilities.insert(value.toString());
-    }
-    if (capabilities.contains("CAP_BATTERY_STATUS")) {
-        QJsonObject jEq = jsonObj["battery"].toObject();
-        battery = Battery(jEq["status"].toString(), jEq["level"].toInt());
-    }
-    if (capabilities.contains("CAP_CHATMIX_STATUS")) {
-        chatmix = jsonObj["chatmix"].toInt();
-    }
+bool DeviceKey::operator==(const DeviceKey &k) const
+{
+    return id == k.id && unit == k.unit;
+}
 
-    if (capabilities.contains("CAP_EQUALIZER_PRESET")) {
-        if (jsonObj.contains("equalizer_presets") && jsonObj["equalizer_presets"].isObject()) {
-            QJsonObject equalizerPresets = jsonObj["equalizer_presets"].toObject();
-
-            // Parse the original JSON string to find the order of keys
-            static QRegularExpression re("\"(\\w+)\":\\s*\\[");
-            QRegularExpressionMatchIterator i = re.globalMatch(jsonData);
-            while (i.hasNext()) {
-                QRegularExpressionMatch match = i.next();
-                QString presetName = match.captured(1);
-                if (equalizerPresets.contains(presetName)) {
-                    EqualizerPreset preset;
-                    preset.name = presetName;
-
-                    QJsonArray valuesArray = equalizerPresets[presetName].toArray();
-                    for (const QJsonValue &value : valuesArray) {
-                        preset.values.append(value.toDouble());
-                    }
-
-                    presets_list.append(preset);
-                }
-            }
-        }
-    }
-    if (capabilities.contains("CAP_EQUALIZER")) {
-        QJsonObject jEq = jsonObj["equalizer"].toObject();
-        if (!jEq.isEmpty()) {
-            equalizer = Equalizer(jEq["bands"].toInt(),
-                                  jEq["baseline"].toInt(),
-                                  jEq["step"].toDouble(),
-                                  jEq["min"].toInt(),
-                                  jEq["max"].toInt());
-            equalizer_curve = QVector<double>(equalizer.bands_number, equalizer.band_baseline);
-        }
-    }
+bool DeviceKey::operator!=(const DeviceKey &k) const
+{
+    return !(*this == k);
 }
 
+size_t qHash(const DeviceKey &key, size_t seed)
+{
+    return qHashMulti(seed, key.id, key.unit);
+}
+
+Device::Device() {}
+
 // Helper functions
+DeviceKey Device::key() const
+{
+    return DeviceKey(DeviceKey::packId(id_vendor, id_product), unit_id);
+}
+
 bool Device::operator!=(const Device &d) const
 {
-    return this->id_vendor != d.id_vendor || this->id_product != d.id_product;
+    return this->key() != d.key();
 }
 
 bool Device::operator==(const Device &d) const
 {
-    return this->id_vendor == d.id_vendor && this->id_product == d.id_product;
+    return this->key() == d.key();
 }
 
-bool Device::operator==(const Device *d) const
+void Device::applySetting(const QString &capability, const QVariant &value)
 {
-    return this->id_vendor == d->id_vendor && this->id_product == d->id_product;
+    if (capability == "CAP_SIDETONE") {
+        sidetone = value.toInt();
+    } else if (capability == "CAP_LIGHTS") {
+        lights = value.toBool();
+    } else if (capability == "CAP_VOICE_PROMPTS") {
+        voice_prompts = value.toBool();
+    } else if (capability == "CAP_INACTIVE_TIME") {
+        inactive_time = value.toInt();
+    } else if (capability == "CAP_NOTIFICATION_SOUND") {
+        notification_sound = value.toInt();
+    } else if (capability == "CAP_VOLUME_LIMITER") {
+        volume_limiter = value.toBool();
+    } else if (capability == "CAP_EQUALIZER") {
+        equalizer_curve = value.value<QList<double>>();
+        equalizer_preset = -1;
+    } else if (capability == "CAP_EQUALIZER_PRESET") {
+        equalizer_preset = value.toInt();
+    } else if (capability == "CAP_ROTATE_TO_MUTE") {
+        rotate_to_mute = value.toBool();
+    } else if (capability == "CAP_MICROPHONE_MUTE_LED_BRIGHTNESS") {
+        mic_mute_led_brightness = value.toInt();
+    } else if (capability == "CAP_MICROPHONE_VOLUME") {
+        mic_volume = value.toInt();
+    } else if (capability == "CAP_BT_WHEN_POWERED_ON") {
+        bt_when_powered_on = value.toBool();
+    } else if (capability == "CAP_BT_CALL_VOLUME") {
+        bt_call_volume = value.toInt();
+    }
 }
 
-void Device::updateDevice(const Device *new_device)
+void Device::copySettings(const Device &source)
 {
-    this->battery = new_device->battery;
-    this->chatmix = new_device->chatmix;
+    this->lights = source.lights;
+    this->sidetone = source.sidetone;
+    this->voice_prompts = source.voice_prompts;
+    this->inactive_time = source.inactive_time;
+
+    this->equalizer_preset = source.equalizer_preset;
+    this->equalizer_curve = source.equalizer_curve;
+    this->volume_limiter = source.volume_limiter;
+
+    this->rotate_to_mute = source.rotate_to_mute;
+    this->mic_mute_led_brightness = source.mic_mute_led_brightness;
+    this->mic_volume = source.mic_volume;
+
+    this->bt_when_powered_on = source.bt_when_powered_on;
+    this->bt_call_volume = source.bt_call_volume;
+}
+
+void Device::updateStatus(const DeviceStatus &new_status)
+{
+    this->status = new_status.status;
+    if (new_status.has_battery) {
+        this->battery = new_status.battery;
+    }
+    if (new_status.has_chatmix) {
+        this->chatmix = new_status.chatmix;
+    }
 }
 
-bool Device::updateDevice(const QList<Device *> &new_device_list)
+bool Device::updateStatus(const QList<DeviceStatus> &new_status_list)
 {
-    for (int i = 0; i < new_device_list.length(); ++i) {
-        if (this != new_device_list.at(i)) {
-            this->updateDevice(new_device_list.at(i));
+    DeviceKey key = this->key();
+    for (const DeviceStatus &new_status : new_status_list) {
+        if (key == DeviceKey(DeviceKey::packId(new_status.id_vendor, new_status.id_product),
+                             new_status.unit_id)) {
+            this->updateStatus(new_status);
             return true;
         }
     }
@@ -127,6 +166,7 @@ QJsonObject Device::toJson() const
     json["product"] = product;
     json["id_vendor"] = id_vendor;
     json["id_product"] = id_product;
+    json["unit_id"] = unit_id;
 
     json["lights"] = lights;
     json["sidetone"] = sidetone;
@@ -153,6 +193,7 @@ Device Device::fromJson(const QJsonObject &json)
     device.product = json["product"].toString();
     device.id_vendor = json["id_vendor"].toString();
     device.id_product = json["id_product"].toString();
+    device.unit_id = json["unit_id"].toString();
 
     device.lights = json["lights"].toInt();
     device.sidetone = json["sidetone"].toInt();
@@ -175,73 +216,62 @@ Device Device::fromJson(const QJsonObject &json)
     return device;
 }
 
-void updateDevicesFromSource(QList<Device *> &devicesToUpdate, const QList<Device *> &sourceDevices)
+void updateDevicesFromSource(QList<Device> &devicesToUpdate,
+                             const QList<Device> &sourceDevices,
+                             bool addMissing)
 {
-    for (Device *sourceDevice : sourceDevices) {
-        bool deviceFound = false;
-        for (Device *toUpdateDevice : devicesToUpdate) {
-            if (toUpdateDevice->id_vendor == sourceDevice->id_vendor
-                && toUpdateDevice->id_product == sourceDevice->id_product) {
-                // Update the connected device with saved device's information
-                toUpdateDevice->lights = sourceDevice->lights;
-                toUpdateDevice->sidetone = sourceDevice->sidetone;
-                toUpdateDevice->voice_prompts = sourceDevice->voice_prompts;
-                toUpdateDevice->inactive_time = sourceDevice->inactive_time;
-
-                toUpdateDevice->equalizer_preset = sourceDevice->equalizer_preset;
-                toUpdateDevice->equalizer_curve = sourceDevice->equalizer_curve;
-                toUpdateDevice->volume_limiter = sourceDevice->volume_limiter;
-
-                toUpdateDevice->rotate_to_mute = sourceDevice->rotate_to_mute;
-                toUpdateDevice->mic_mute_led_brightness = sourceDevice->mic_mute_led_brightness;
-                toUpdateDevice->mic_volume = sourceDevice->mic_volume;
-
-                toUpdateDevice->bt_when_powered_on = sourceDevice->bt_when_powered_on;
-                toUpdateDevice->bt_call_volume = sourceDevice->bt_call_volume;
-
-                deviceFound = true;
-                break;
+    // Appending may move the elements, so missing devices are added after the lookups
+    QList<Device> missing;
+    {
+        DeviceRegistry registry(devicesToUpdate);
+        for (const Device &sourceDevice : sourceDevices) {
+            Device *toUpdateDevice = registry.find(sourceDevice);
+            if (toUpdateDevice != nullptr) {
+                toUpdateDevice->copySettings(sourceDevice);
+            } else if (addMissing) {
+                missing.append(sourceDevice);
             }
         }
-
-        if (!deviceFound) {
-            // If the device wasn't found in saved devices, add it
-            devicesToUpdate.append(sourceDevice);
-        }
-    };
+    }
+    devicesToUpdate.append(missing);
 }
 
-void serializeDevices(const QList<Device *> &devices, const QString &filePath)
+bool serializeDevices(const QList<Device> &devices, const QString &filePath, bool binary)
 {
-    QJsonArray jsonArray;
-    for (const auto *device : devices) {
-        jsonArray.append(device->toJson());
+    QCborArray array;
+    for (const Device &device : devices) {
+        array.append(QCborMap::fromJsonObject(device.toJson()));
     }
 
-    QJsonDocument doc(jsonArray);
-    QFile file(filePath);
-    if (file.open(QIODevice::WriteOnly)) {
-        file.write(doc.toJson());
-        file.close();
-        qDebug() << "Devices Serialized" << jsonArray;
+    if (!ConfigFile(filePath).write(array, binary ? ConfigFile::Cbor : ConfigFile::Json)) {
+        return false;
     }
+    qDebug() << "Devices Serialized:" << devices.size();
+    return true;
 }
 
-QList<Device *> deserializeDevices(const QString &filePath)
+QList<Device> deserializeDevices(const QString &filePath)
 {
-    QList<Device *> devices;
-    QFile file(filePath);
-    if (file.open(QIODevice::ReadOnly)) {
-        QByteArray data = file.readAll();
-        QJsonDocument doc = QJsonDocument::fromJson(data);
-        QJsonArray jsonArray = doc.array();
+    QList<Device> devices;
+    QCborArray array = ConfigFile(filePath).read().toArray();
 
-        for (const auto &value : jsonArray) {
-            Device *device = new Device(Device::fromJson(value.toObject()));
-            devices.append(device);
+    devices.reserve(array.size());
+    for (const QCborValue &value : array) {
+        devices.append(Device::fromJson(value.toMap().toJsonObject()));
+    }
+    // Files written before units were told apart have no unit_id, and those written
+    // while units were named after their enumeration position have a "#n" one. Both
+    // get the name of the unit that position stands for now.
+    bool legacyIds = false;
+    for (Device &device : devices) {
+        if (device.unit_id.startsWith('#')) {
+            device.unit_id.clear();
         }
-
-        file.close();
+        legacyIds = legacyIds || device.unit_id.isEmpty();
     }
+    if (legacyIds) {
+        DeviceRegistry::assignUnitIds(devices, DeviceRegistry::physicalUnits());
+    }
+
     return devices;
 }
@@ -4,6 +4,7 @@
 #include <QJsonObject>
 #include <QSet>
 #include <QString>
+#include <QVariant>
 
 class Battery
 {
@@ -34,11 +35,55 @@ public:
     int band_max = 0;
 };
 
+// Identifies one physical unit: VID:PID packed in 32 bits plus a per-unit
+// discriminator, so two identical headsets keep separate settings
+class DeviceKey
+{
+public:
+    DeviceKey();
+    DeviceKey(quint32 id, const QString &unit);
+
+    // Parses ids as printed by headsetcontrol, e.g. "0x1038"; returns 0 when malformed
+    static quint16 parseId(const QString &id);
+    static quint32 packId(const QString &id_vendor, const QString &id_product);
+
+    quint32 id = 0;
+    QString unit;
+
+    bool operator==(const DeviceKey &k) const;
+    bool operator!=(const DeviceKey &k) const;
+};
+
+size_t qHash(const DeviceKey &key, size_t seed = 0);
+
+// Just the values that change while a headset stays connected, as read by a status poll
+class DeviceStatus
+{
+public:
+    QString id_vendor;
+    QString id_product;
+    QString unit_id;
+    QString status;
+
+    bool has_battery = false;
+    Battery battery;
+    bool has_chatmix = false;
+    int chatmix = 65;
+};
+
+// What the poller last reported, published as a whole
+class DeviceState
+{
+public:
+    // Grows with every publication, 0 before the first one
+    quint64 sequence = 0;
+    QList<DeviceStatus> statuses;
+};
+
 class Device
 {
 public:
     Device();
-    Device(const QJsonObject &jsonObj, QString jsonData);
 
     // Status
     QString status;
@@ -49,6 +94,8 @@ public:
     QString product;
     QString id_vendor;
     QString id_product;
+    // Tells identical headsets apart, see DeviceRegistry::assignUnitIds()
+    QString unit_id;
     QSet<QString> capabilities;
 
     // Info to get from json and display
@@ -72,20 +119,33 @@ public:
     int bt_when_powered_on = -1;
     int bt_call_volume = -1;
 
+    DeviceKey key() const;
+
     bool operator!=(const Device &d) const;
     bool operator==(const Device &d) const;
-    bool operator==(const Device *d) const;
 
-    void updateDevice(const Device *new_device);
-    bool updateDevice(const QList<Device *> &new_device_list);
+    // Stores a value confirmed by headsetcontrol into the matching field
+    void applySetting(const QString &capability, const QVariant &value);
+
+    // Copies the user settings (not identity or status) from another unit
+    void copySettings(const Device &source);
+    void updateStatus(const DeviceStatus &new_status);
+    // Returns false when this device is not in the list anymore
+    bool updateStatus(const QList<DeviceStatus> &new_status_list);
 
     QJsonObject toJson() const;
     static Device fromJson(const QJsonObject &json);
 };
 
-void updateDevicesFromSource(QList<Device *> &devicesToUpdate, const QList<Device *> &sourceDevices);
+// Copies settings from sourceDevices onto the matching units of devicesToUpdate.
+// With addMissing, units not found there are appended as copies.
+void updateDevicesFromSource(QList<Device> &devicesToUpdate,
+                             const QList<Device> &sourceDevices,
+                             bool addMissing);
 
-void serializeDevices(const QList<Device *> &devices, const QString &filePath);
-QList<Device *> deserializeDevices(const QString &filePath);
+// Replaces the file atomically; returns false if it couldn't be written
+bool serializeDevices(const QList<Device> &devices, const QString &filePath, bool binary = false);
+// Reads the binary file next to filePath if there is one, see ConfigFile
+QList<Device> deserializeDevices(const QString &filePath);
 
 #endif // DEVICE_H
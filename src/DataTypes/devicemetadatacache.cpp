@@ -0,0 +1,19 @@
+#include "devicemetadatacache.h"
+
+DeviceMetadataCache::DeviceMetadataCache() {}
+
+const Device *DeviceMetadataCache::find(quint32 id) const
+{
+    auto it = devices.constFind(id);
+    return it == devices.constEnd() ? nullptr : &it.value();
+}
+
+void DeviceMetadataCache::insert(quint32 id, const Device &metadata)
+{
+    devices.insert(id, metadata);
+}
+
+void DeviceMetadataCache::clear()
+{
+    devices.clear();
+}
@@ -0,0 +1,25 @@
+#ifndef DEVICEMETADATACACHE_H
+#define DEVICEMETADATACACHE_H
+
+#include "device.h"
+
+#include <QHash>
+
+// Remembers the static part of every device seen so far, keyed by the packed
+// VID:PID of DeviceKey, so later polls only have to read status, battery and chatmix
+class DeviceMetadataCache
+{
+public:
+    DeviceMetadataCache();
+
+    // Returns nullptr for a VID:PID not seen yet; the pointer is valid until the next insert
+    const Device *find(quint32 id) const;
+    void insert(quint32 id, const Device &metadata);
+
+    void clear();
+
+private:
+    QHash<quint32, Device> devices;
+};
+
+#endif // DEVICEMETADATACACHE_H
@@ -0,0 +1,128 @@
+#include "deviceregistry.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+
+#include <algorithm>
+
+DeviceRegistry::DeviceRegistry() {}
+
+DeviceRegistry::DeviceRegistry(QList<Device> &devices)
+{
+    index.reserve(devices.size());
+    for (Device &device : devices) {
+        insert(&device);
+    }
+}
+
+static QString unitIdFor(const QHash<quint32, QStringList> &units, quint32 id, int occurrence)
+{
+    QString unit = units.value(id).value(occurrence);
+    return unit.isEmpty() ? "#" + QString::number(occurrence) : unit;
+}
+
+void DeviceRegistry::assignUnitIds(QList<Device> &devices, const QHash<quint32, QStringList> &units)
+{
+    QHash<quint32, int> seen;
+    for (Device &device : devices) {
+        quint32 id = DeviceKey::packId(device.id_vendor, device.id_product);
+        int occurrence = seen[id]++;
+        if (device.unit_id.isEmpty()) {
+            device.unit_id = unitIdFor(units, id, occurrence);
+        }
+    }
+}
+
+void DeviceRegistry::assignUnitIds(QList<DeviceStatus> &statuses,
+                                   const QHash<quint32, QStringList> &units)
+{
+    QHash<quint32, int> seen;
+    for (DeviceStatus &status : statuses) {
+        quint32 id = DeviceKey::packId(status.id_vendor, status.id_product);
+        int occurrence = seen[id]++;
+        if (status.unit_id.isEmpty()) {
+            status.unit_id = unitIdFor(units, id, occurrence);
+        }
+    }
+}
+
+QHash<quint32, QStringList> DeviceRegistry::physicalUnits(const QString &sysfsRoot)
+{
+    QHash<quint32, QStringList> units;
+
+    // hidapi walks the nodes in the order of their device paths, not of their names
+    QDir root(sysfsRoot);
+    QStringList nodes;
+    const QStringList names = root.entryList(QStringList() << "hidraw*",
+                                             QDir::Dirs | QDir::System | QDir::NoDotAndDotDot);
+    for (const QString &name : names) {
+        nodes.append(QFileInfo(root.filePath(name)).canonicalFilePath());
+    }
+    std::sort(nodes.begin(), nodes.end());
+
+    // One headset exposes several interfaces, "usb-0000:00:14.0-2/input3" and so on
+    static QRegularExpression interfaceSuffix("/input\\d+$");
+    for (const QString &node : std::as_const(nodes)) {
+        QFile uevent(node + "/device/uevent");
+        if (!uevent.open(QIODevice::ReadOnly)) {
+            continue;
+        }
+        // e.g. "HID_ID=0003:00001038:00002202", "HID_PHYS=usb-...", "HID_UNIQ=..."
+        quint32 id = 0;
+        QString phys;
+        QString uniq;
+        for (const QByteArray &line : uevent.readAll().split('\n')) {
+            if (line.startsWith("HID_ID=")) {
+                QList<QByteArray> parts = line.mid(7).split(':');
+                if (parts.size() == 3) {
+                    id = parts.at(1).toUInt(nullptr, 16) << 16 | parts.at(2).toUInt(nullptr, 16);
+                }
+            } else if (line.startsWith("HID_PHYS=")) {
+                phys = QString::fromUtf8(line.mid(9)).remove(interfaceSuffix);
+            } else if (line.startsWith("HID_UNIQ=")) {
+                uniq = QString::fromUtf8(line.mid(9));
+            }
+        }
+
+        QString unit = uniq.isEmpty() ? phys : uniq;
+        if (id != 0 && !unit.isEmpty() && !units[id].contains(unit)) {
+            units[id].append(unit);
+        }
+    }
+    return units;
+}
+
+void DeviceRegistry::insert(Device *device)
+{
+    index.insert(device->key(), device);
+}
+
+void DeviceRegistry::remove(const Device *device)
+{
+    auto it = index.find(device->key());
+    if (it != index.end() && it.value() == device) {
+        index.erase(it);
+    }
+}
+
+void DeviceRegistry::clear()
+{
+    index.clear();
+}
+
+Device *DeviceRegistry::find(const DeviceKey &key) const
+{
+    return index.value(key, nullptr);
+}
+
+Device *DeviceRegistry::find(const Device &device) const
+{
+    return find(device.key());
+}
+
+int DeviceRegistry::size() const
+{
+    return index.size();
+}
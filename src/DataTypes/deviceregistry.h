@@ -0,0 +1,46 @@
+#ifndef DEVICEREGISTRY_H
+#define DEVICEREGISTRY_H
+
+#include "device.h"
+
+#include <QHash>
+#include <QList>
+#include <QStringList>
+
+// O(1) lookup of devices by DeviceKey. Doesn't own the devices it indexes:
+// pointers stay valid only as long as the container they point into isn't resized.
+class DeviceRegistry
+{
+public:
+    DeviceRegistry();
+    explicit DeviceRegistry(QList<Device> &devices);
+
+    // headsetcontrol reports no serial, so the n-th unit of a model is named after
+    // the n-th entry of units for its VID:PID, see physicalUnits(). Units found
+    // nowhere there fall back to their position among devices of the same model
+    // ("#0", "#1", ...). Units that already have an id keep it.
+    static void assignUnitIds(QList<Device> &devices,
+                              const QHash<quint32, QStringList> &units = {});
+    static void assignUnitIds(QList<DeviceStatus> &statuses,
+                              const QHash<quint32, QStringList> &units = {});
+
+    // Stable names of the attached units of each packed VID:PID, read from the
+    // uevent of every hidraw node: the HID_UNIQ serial, or the HID_PHYS port path
+    // when the device has none. Listed in the order hidapi enumerates them in,
+    // which is the order headsetcontrol reports them in. Empty without sysfs.
+    static QHash<quint32, QStringList> physicalUnits(
+        const QString &sysfsRoot = QString("/sys/class/hidraw"));
+
+    void insert(Device *device);
+    void remove(const Device *device);
+    void clear();
+
+    Device *find(const DeviceKey &key) const;
+    Device *find(const Device &device) const;
+    int size() const;
+
+private:
+    QHash<DeviceKey, Device *> index;
+};
+
+#endif // DEVICEREGISTRY_H
@@ -0,0 +1,63 @@
+#include "devicesettingsstore.h"
+
+#include <QCoreApplication>
+
+DeviceSettingsStore::DeviceSettingsStore(const QString &filePath, QObject *parent)
+    : QObject(parent)
+    , filePath(filePath)
+    , saved(deserializeDevices(filePath))
+{
+    flushTimer.setSingleShot(true);
+    connect(&flushTimer, &QTimer::timeout, this, &DeviceSettingsStore::flush);
+    // The destructor may not run when the application is torn down from the tray
+    connect(qApp, &QCoreApplication::aboutToQuit, this, &DeviceSettingsStore::flush);
+}
+
+DeviceSettingsStore::~DeviceSettingsStore()
+{
+    flush();
+}
+
+const QList<Device> &DeviceSettingsStore::devices() const
+{
+    return saved;
+}
+
+void DeviceSettingsStore::update(const QList<Device> &devices)
+{
+    updateDevicesFromSource(saved, devices, true);
+    dirty = true;
+    flushTimer.start(MSEC_FLUSH_DELAY);
+}
+
+void DeviceSettingsStore::flush()
+{
+    flushTimer.stop();
+    if (!dirty) {
+        return;
+    }
+    dirty = !serializeDevices(saved, filePath, binary);
+    if (!dirty) {
+        writes++;
+    }
+}
+
+void DeviceSettingsStore::setBinary(bool binary)
+{
+    if (this->binary == binary) {
+        return;
+    }
+    this->binary = binary;
+    dirty = !saved.isEmpty();
+    flushTimer.start(MSEC_FLUSH_DELAY);
+}
+
+bool DeviceSettingsStore::isDirty() const
+{
+    return dirty;
+}
+
+int DeviceSettingsStore::writeCount() const
+{
+    return writes;
+}
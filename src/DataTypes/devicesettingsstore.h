@@ -0,0 +1,44 @@
+#ifndef DEVICESETTINGSSTORE_H
+#define DEVICESETTINGSSTORE_H
+
+#include "device.h"
+
+#include <QObject>
+#include <QTimer>
+
+// In-memory copy of devices.json. It is read once; changes mark it dirty and
+// get written back after a short quiet period, and at shutdown, so a burst of
+// actions costs one write instead of one read-merge-write each.
+class DeviceSettingsStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit DeviceSettingsStore(const QString &filePath, QObject *parent = nullptr);
+    ~DeviceSettingsStore();
+
+    const QList<Device> &devices() const;
+
+    // Stores the settings of the given devices, adding unknown units
+    void update(const QList<Device> &devices);
+    void flush();
+
+    // Switching format rewrites the file in the new one
+    void setBinary(bool binary);
+
+    bool isDirty() const;
+    // Times the file was written since the store was created
+    int writeCount() const;
+
+private:
+    static constexpr int MSEC_FLUSH_DELAY = 1000;
+
+    QString filePath;
+    QList<Device> saved;
+    bool dirty = false;
+    bool binary = false;
+    int writes = 0;
+    QTimer flushTimer;
+};
+
+#endif // DEVICESETTINGSSTORE_H
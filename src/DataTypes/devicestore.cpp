@@ -0,0 +1,62 @@
+#include "devicestore.h"
+
+DeviceStore::DeviceStore() {}
+
+void DeviceStore::assign(const QList<Device> &devices)
+{
+    bool sameUnits = int(this->devices.size()) == devices.size();
+
+    // Shrinking keeps the capacity, and copy-assigning shares the implicitly
+    // shared strings and lists, so refreshing the same devices allocates nothing
+    this->devices.resize(devices.size());
+    for (int i = 0; i < devices.size(); ++i) {
+        sameUnits = sameUnits && this->devices[i].key() == devices.at(i).key();
+        this->devices[i] = devices.at(i);
+    }
+
+    if (!sameUnits) {
+        index.clear();
+        for (int i = 0; i < devices.size(); ++i) {
+            index.insert(this->devices[i].key(), i);
+        }
+    }
+}
+
+void DeviceStore::clear()
+{
+    devices.clear();
+    index.clear();
+}
+
+DeviceStore::Handle DeviceStore::find(const DeviceKey &key) const
+{
+    return index.value(key, InvalidHandle);
+}
+
+Device *DeviceStore::get(Handle handle)
+{
+    if (handle < 0 || handle >= int(devices.size())) {
+        return nullptr;
+    }
+    return &devices[handle];
+}
+
+const Device &DeviceStore::at(Handle handle) const
+{
+    return devices.at(handle);
+}
+
+int DeviceStore::size() const
+{
+    return int(devices.size());
+}
+
+bool DeviceStore::isEmpty() const
+{
+    return devices.empty();
+}
+
+QList<Device> DeviceStore::toList() const
+{
+    return QList<Device>(devices.begin(), devices.end());
+}
@@ -0,0 +1,41 @@
+#ifndef DEVICESTORE_H
+#define DEVICESTORE_H
+
+#include "device.h"
+
+#include <QHash>
+#include <QList>
+
+#include <vector>
+
+// The connected devices, stored by value in one contiguous block whose
+// elements are reused from one enumeration to the next. A Handle is a position
+// in the store; find() maps a unit back to its handle after a refresh.
+// Pointers from get() stay valid until the next assign() or clear().
+class DeviceStore
+{
+public:
+    using Handle = int;
+    static constexpr Handle InvalidHandle = -1;
+
+    DeviceStore();
+
+    // Copies the devices in place over the current elements
+    void assign(const QList<Device> &devices);
+    void clear();
+
+    Handle find(const DeviceKey &key) const;
+    Device *get(Handle handle);
+    const Device &at(Handle handle) const;
+
+    int size() const;
+    bool isEmpty() const;
+
+    QList<Device> toList() const;
+
+private:
+    std::vector<Device> devices;
+    QHash<DeviceKey, Handle> index;
+};
+
+#endif // DEVICESTORE_H
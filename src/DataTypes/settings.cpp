@@ -1,23 +1,49 @@
 #include "settings.h"
 
-#include <QFile>
-#include <QJsonDocument>
+#include "configfile.h"
+
+#include <QCborMap>
 #include <QJsonObject>
 
 Settings::Settings() {}
 
+static QCborValue migrateSettings(const QCborValue &data, int schema)
+{
+    if (!data.isMap()) {
+        return data;
+    }
+
+    QCborMap json = data.toMap();
+    switch (schema) {
+    case 0:
+        // Schema 0 polled at one fixed interval. Widen the adaptive range around it, or the
+        // default bounds would override the interval the user picked.
+        if (json.contains(QStringLiteral("msecUpdateIntervalTime"))
+            && !json.contains(QStringLiteral("msecMinUpdateIntervalTime"))) {
+            Settings defaults;
+            int interval = int(json.value(QStringLiteral("msecUpdateIntervalTime")).toInteger());
+            json[QStringLiteral("msecMinUpdateIntervalTime")]
+                = qMin(interval, defaults.msecMinUpdateIntervalTime);
+            json[QStringLiteral("msecMaxUpdateIntervalTime")]
+                = qMax(interval, defaults.msecMaxUpdateIntervalTime);
+        }
+        [[fallthrough]];
+    default:
+        break;
+    }
+    return json;
+}
+
 Settings loadSettingsFromFile(const QString &filePath)
 {
     Settings s;
 
-    QFile file(filePath);
+    ConfigFile file(filePath, migrateSettings);
+    s.binaryConfig = file.existingFormat() == ConfigFile::Cbor;
 
-    if (file.open(QIODevice::ReadOnly)) {
-        QByteArray saveData = file.readAll();
-        file.close();
-
-        QJsonDocument doc(QJsonDocument::fromJson(saveData));
-        QJsonObject json = doc.object();
+    QCborValue data = file.read();
+    if (data.isMap()) {
+        QJsonObject json = data.toMap().toJsonObject();
 
         if (json.contains("runOnStartup")) {
             s.runOnstartup = json["runOnStartup"].toBool();
@@ -31,16 +57,30 @@ Settings loadSettingsFromFile(const QString &filePath)
         if (json.contains("audioNotification")) {
             s.batteryLowThreshold = json["audioNotification"].toInt();
         }
+        if (json.contains("listenInputReports")) {
+            s.listenInputReports = json["listenInputReports"].toBool();
+        }
         if (json.contains("batteryLowThreshold")) {
             s.batteryLowThreshold = json["batteryLowThreshold"].toInt();
         }
         if (json.contains("msecUpdateIntervalTime")) {
             s.msecUpdateIntervalTime = json["msecUpdateIntervalTime"].toInt();
         }
+        if (json.contains("msecMinUpdateIntervalTime")) {
+            s.msecMinUpdateIntervalTime = json["msecMinUpdateIntervalTime"].toInt();
+        }
+        if (json.contains("msecMaxUpdateIntervalTime")) {
+            s.msecMaxUpdateIntervalTime = json["msecMaxUpdateIntervalTime"].toInt();
+        }
+        if (json.contains("msecCommandIntervalTime")) {
+            s.msecCommandIntervalTime = qBound(Settings::MSEC_MIN_COMMAND_INTERVAL,
+                                               json["msecCommandIntervalTime"].toInt(),
+                                               Settings::MSEC_MAX_COMMAND_INTERVAL);
+        }
         if (json.contains("styleName")) {
             s.styleName = json["styleName"].toString();
         }
-        qDebug() << "Settings Loaded:\t" << json;
+        qDebug() << "Settings Loaded";
     }
 
     return s;
@@ -53,18 +93,17 @@ void saveSettingstoFile(const Settings &settings, const QString &filePath)
     json["notificationBatteryFull"] = settings.notificationBatteryFull;
     json["notificationBatteryLow"] = settings.notificationBatteryLow;
     json["audioNotification"] = settings.audioNotification;
+    json["listenInputReports"] = settings.listenInputReports;
     json["batteryLowThreshold"] = settings.batteryLowThreshold;
     json["msecUpdateIntervalTime"] = settings.msecUpdateIntervalTime;
+    json["msecMinUpdateIntervalTime"] = settings.msecMinUpdateIntervalTime;
+    json["msecMaxUpdateIntervalTime"] = settings.msecMaxUpdateIntervalTime;
+    json["msecCommandIntervalTime"] = settings.msecCommandIntervalTime;
     json["styleName"] = settings.styleName;
 
-    QJsonDocument doc(json);
-    QFile file(filePath);
-
-    if (!file.open(QIODevice::WriteOnly)) {
-        qWarning("Couldn't open save file.");
+    ConfigFile file(filePath);
+    if (file.write(QCborMap::fromJsonObject(json),
+                   settings.binaryConfig ? ConfigFile::Cbor : ConfigFile::Json)) {
+        qDebug() << "Settings Saved";
     }
-
-    file.write(doc.toJson());
-    file.close();
-    qDebug() << "Settings Saved:\t" << json;
 }
@@ -15,6 +15,8 @@ const QString PROGRAM_CONFIG_PATH = QStandardPaths::writableLocation(QStandardPa
 const QString PROGRAM_STYLES_PATH = PROGRAM_CONFIG_PATH + "/styles";
 const QString PROGRAM_SETTINGS_FILEPATH = PROGRAM_CONFIG_PATH + "/settings.json";
 const QString DEVICES_SETTINGS_FILEPATH = PROGRAM_CONFIG_PATH + "/devices.json";
+const QString UPDATE_CACHE_FILEPATH = PROGRAM_CONFIG_PATH + "/update_cache.json";
+const QString PRESET_LIBRARY_INDEX_FILEPATH = PROGRAM_CONFIG_PATH + "/presets.idx";
 
 class Settings
 {
@@ -28,9 +30,20 @@ public:
     int batteryLowThreshold = 15;
     bool audioNotification = true;
 
+    bool listenInputReports = false;
+
     int msecUpdateIntervalTime = 30000;
+    int msecMinUpdateIntervalTime = 5000;
+    int msecMaxUpdateIntervalTime = 120000;
+    // Clamped to this range when loaded: 0 would let sliders flood the device
+    static constexpr int MSEC_MIN_COMMAND_INTERVAL = 20;
+    static constexpr int MSEC_MAX_COMMAND_INTERVAL = 2000;
+    int msecCommandIntervalTime = 100;
 
     QString styleName = "Default";
+
+    // Not stored as a value: it is whichever format the settings file is in
+    bool binaryConfig = false;
 };
 
 Settings loadSettingsFromFile(const QString &filePath);
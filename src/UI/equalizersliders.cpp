@@ -0,0 +1,63 @@
+#include "equalizersliders.h"
+
+#include <QLabel>
+
+EqualizerSliders::EqualizerSliders() {}
+
+void EqualizerSliders::configure(QHBoxLayout *layout,
+                                 const Equalizer &equalizer,
+                                 const QList<double> &curve)
+{
+    resize(layout, qMax(0, equalizer.bands_number));
+
+    for (int i = 0; i < slidersEq.size(); ++i) {
+        QSlider *s = slidersEq.at(i);
+        s->setRange(equalizer.band_min / equalizer.band_step,
+                    equalizer.band_max / equalizer.band_step);
+        s->setSingleStep(1);
+        s->setTickInterval(1 / equalizer.band_step);
+        if (curve.size() == equalizer.bands_number) {
+            s->setValue(curve.value(i));
+        } else {
+            s->setValue(equalizer.band_baseline);
+        }
+    }
+}
+
+void EqualizerSliders::resize(QHBoxLayout *layout, int bands)
+{
+    while (slidersEq.size() < bands) {
+        QLabel *l = new QLabel(QString::number(slidersEq.size()));
+        l->setAlignment(Qt::AlignHCenter);
+
+        QSlider *s = new QSlider(Qt::Vertical);
+        s->setTickPosition(QSlider::TicksBothSides);
+
+        QVBoxLayout *lb = new QVBoxLayout();
+        lb->addWidget(l);
+        lb->addWidget(s);
+
+        slidersEq.append(s);
+        layout->addLayout(lb);
+    }
+    while (slidersEq.size() > bands) {
+        QLayoutItem *item = layout->takeAt(layout->count() - 1);
+        QLayout *band = item->layout();
+        while (QLayoutItem *child = band->takeAt(0)) {
+            delete child->widget();
+            delete child;
+        }
+        delete item;
+        slidersEq.removeLast();
+    }
+}
+
+const QList<QSlider *> &EqualizerSliders::sliders() const
+{
+    return slidersEq;
+}
+
+bool EqualizerSliders::isEmpty() const
+{
+    return slidersEq.isEmpty();
+}
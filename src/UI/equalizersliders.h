@@ -0,0 +1,29 @@
+#ifndef EQUALIZERSLIDERS_H
+#define EQUALIZERSLIDERS_H
+
+#include "device.h"
+
+#include <QHBoxLayout>
+#include <QList>
+#include <QSlider>
+
+// The band sliders of the equalizer tab, one labelled column per band in the given
+// layout. They are kept between devices and only added or removed when the band
+// count changes; switching between devices with the same count only touches values.
+class EqualizerSliders
+{
+public:
+    EqualizerSliders();
+
+    // Shows curve when it has one value per band, the baseline otherwise
+    void configure(QHBoxLayout *layout, const Equalizer &equalizer, const QList<double> &curve);
+    void resize(QHBoxLayout *layout, int bands);
+
+    const QList<QSlider *> &sliders() const;
+    bool isEmpty() const;
+
+private:
+    QList<QSlider *> slidersEq;
+};
+
+#endif // EQUALIZERSLIDERS_H
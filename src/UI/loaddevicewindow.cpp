@@ -1,15 +1,25 @@
 #include "loaddevicewindow.h"
 #include "ui_loaddevicewindow.h"
 
-LoaddeviceWindow::LoaddeviceWindow(const QList<Device *> &devices, QWidget *parent)
+LoaddeviceWindow::LoaddeviceWindow(const QList<Device> &devices, QWidget *parent)
     : QDialog(parent)
     , ui(new Ui::loaddevicewindow)
 {
     setModal(true);
     ui->setupUi(this);
 
-    for (Device *device : devices) {
-        ui->devicelistComboBox->addItem(device->device);
+    setDevices(devices);
+}
+
+void LoaddeviceWindow::setDevices(const QList<Device> &devices)
+{
+    int index = ui->devicelistComboBox->currentIndex();
+    ui->devicelistComboBox->clear();
+    for (const Device &device : devices) {
+        ui->devicelistComboBox->addItem(device.device);
+    }
+    if (index >= 0 && index < devices.length()) {
+        ui->devicelistComboBox->setCurrentIndex(index);
     }
 }
 
@@ -14,10 +14,11 @@ class LoaddeviceWindow : public QDialog
     Q_OBJECT
 
 public:
-    explicit LoaddeviceWindow(const QList<Device *> &devices, QWidget *parent = nullptr);
+    explicit LoaddeviceWindow(const QList<Device> &devices, QWidget *parent = nullptr);
     ~LoaddeviceWindow();
 
     int getDeviceIndex();
+    void setDevices(const QList<Device> &devices);
 
 private:
     Ui::loaddevicewindow *ui;
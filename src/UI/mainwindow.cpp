@@ -3,14 +3,19 @@
 
 #include "device.h"
 #include "dialoginfo.h"
+#include "equalizerfit.h"
 #include "headsetcontrolapi.h"
 #include "loaddevicewindow.h"
+#include "presetlibrarywindow.h"
 #include "settingswindow.h"
+#include "startuptimeline.h"
 #include "utils.h"
 
 #include <QFile>
 #include <QFileDialog>
+#include <QPointer>
 #include <QScreen>
+#include <QSignalBlocker>
 #include <QStyleHints>
 #include <QtConcurrent/QtConcurrent>
 
@@ -20,44 +25,88 @@ MainWindow::MainWindow(QWidget *parent)
     , trayIcon(new QSystemTrayIcon(this))
     , trayMenu(new QMenu(this))
     , timerGUI(new QTimer(this))
-    , API(HeadsetControlAPI(HEADSETCONTROL_FILE_PATH))
+    , API(new HeadsetControlAPI(HEADSETCONTROL_FILE_PATH))
 {
+    StartupTimeline &timeline = StartupTimeline::instance();
+
+    // The tray icon comes first: at login it is all the user is waiting for
+    updateIconsTheme();
+    setupTrayIcon();
+    timeline.mark("tray icon");
+
     QDir().mkpath(PROGRAM_CONFIG_PATH);
-    createStartMenuShortcut();
     settings = loadSettingsFromFile(PROGRAM_SETTINGS_FILEPATH);
-    defaultStyle = styleSheet();
+    timeline.mark("settings");
 
-    setupTrayIcon();
+    // headsetcontrol runs and HID I/O stay off the GUI thread
+    apiThread.setObjectName("HeadsetControlAPI");
+    API->moveToThread(&apiThread);
+    connect(&apiThread, &QThread::finished, API, &QObject::deleteLater);
+    apiThread.start();
+    API->setCommandInterval(settings.msecCommandIntervalTime);
+    timeline.mark("API thread");
+
+    defaultStyle = styleSheet();
     ui->setupUi(this);
     bindEvents();
-
-    updateIconsTheme();
-    updateStyle();
-
     resetGUI();
 
-    updateGUI();
-
-    connect(&API, &HeadsetControlAPI::actionSuccesful, this, &::MainWindow::saveDevicesSettings);
+    connect(API, &HeadsetControlAPI::settingApplied, this, &::MainWindow::settingApplied);
+    connect(API, &HeadsetControlAPI::actionSuccesful, this, &::MainWindow::saveDevicesSettings);
+    connect(API, &HeadsetControlAPI::statusUpdated, this, &::MainWindow::statusUpdated);
+    connect(&hotplugMonitor,
+            &HotplugMonitor::devicesChanged,
+            this,
+            &::MainWindow::hotplugDetected);
+    connect(&inputReportListener,
+            &InputReportListener::reportDecoded,
+            this,
+            &::MainWindow::inputReportDecoded);
 
     connect(timerGUI, &QTimer::timeout, this, &::MainWindow::updateGUI);
-    timerGUI->start(settings.msecUpdateIntervalTime);
+    applyPollSettings();
+
+    // Theme changes only reach a window that was created once; it doesn't need to be shown
+    winId();
+    timeline.mark("main window");
 
-    //Small trick to make work theme style change (Won't work unless you show window once)
-    show();
-    hide();
+    // Everything else waits for the event loop to be running
+    QTimer::singleShot(0, this, &MainWindow::startDeferredStages);
 }
 
-void MainWindow::deleteDevices(QList<Device *> deviceList)
+void MainWindow::startDeferredStages()
 {
-    for (Device *device : deviceList) {
-        delete device;
-    }
-    deviceList.clear();
+    StartupTimeline &timeline = StartupTimeline::instance();
+
+    // Needed by the first device update below
+    savedDevices = std::make_unique<DeviceSettingsStore>(DEVICES_SETTINGS_FILEPATH);
+    savedDevices->setBinary(settings.binaryConfig);
+    timeline.mark("saved devices");
+
+    styleManager = std::make_unique<StyleManager>(PROGRAM_STYLES_PATH);
+    connect(styleManager.get(),
+            &StyleManager::styleSheetChanged,
+            this,
+            &MainWindow::applyStyleSheet);
+    updateStyle();
+    timeline.mark("styles");
+
+    presetLibrary = std::make_unique<PresetLibrary>(PRESET_LIBRARY_INDEX_FILEPATH);
+    updateChecker = std::make_unique<UpdateChecker>(UPDATE_CACHE_FILEPATH);
+    timeline.mark("preset library and update cache");
+
+    createStartMenuShortcut();
+    timeline.mark("start menu shortcut");
+
+    // The timeline ends with the first device update, see updateStatusGUI()
+    updateGUI();
+    timeline.mark("device discovery started");
 }
 
 MainWindow::~MainWindow()
 {
+    apiThread.quit();
+    apiThread.wait();
     timerGUI->stop();
     delete timerGUI;
     delete trayMenu;
@@ -99,29 +148,29 @@ void MainWindow::bindEvents()
     });
 
     // Other Section
-    connect(ui->onlightButton, &QPushButton::clicked, &API, [=]() {
-        API.setLights(selectedDevice, true);
+    connect(ui->onlightButton, &QPushButton::clicked, API, [=]() {
+        API->setLights(true);
     });
-    connect(ui->offlightButton, &QPushButton::clicked, &API, [=]() {
-        API.setLights(selectedDevice, false);
+    connect(ui->offlightButton, &QPushButton::clicked, API, [=]() {
+        API->setLights(false);
     });
-    connect(ui->sidetoneSlider, &QSlider::sliderReleased, &API, [=]() {
-        API.setSidetone(selectedDevice, ui->sidetoneSlider->value());
+    connect(ui->sidetoneSlider, &QSlider::valueChanged, API, [=](int value) {
+        API->setSidetone(value);
     });
-    connect(ui->voiceOnButton, &QPushButton::clicked, &API, [=]() {
-        API.setVoicePrompts(selectedDevice, true);
+    connect(ui->voiceOnButton, &QPushButton::clicked, API, [=]() {
+        API->setVoicePrompts(true);
     });
-    connect(ui->voiceOffButton, &QPushButton::clicked, &API, [=]() {
-        API.setVoicePrompts(selectedDevice, true);
+    connect(ui->voiceOffButton, &QPushButton::clicked, API, [=]() {
+        API->setVoicePrompts(true);
     });
-    connect(ui->notification0Button, &QPushButton::clicked, &API, [=]() {
-        API.playNotificationSound(selectedDevice, 0);
+    connect(ui->notification0Button, &QPushButton::clicked, API, [=]() {
+        API->playNotificationSound(0);
     });
-    connect(ui->notification1Button, &QPushButton::clicked, &API, [=]() {
-        API.playNotificationSound(selectedDevice, 1);
+    connect(ui->notification1Button, &QPushButton::clicked, API, [=]() {
+        API->playNotificationSound(1);
     });
-    connect(ui->inactivitySlider, &QSlider::sliderReleased, &API, [=]() {
-        API.setInactiveTime(selectedDevice, ui->inactivitySlider->value());
+    connect(ui->inactivitySlider, &QSlider::valueChanged, API, [=](int value) {
+        API->setInactiveTime(value);
     });
 
     // Equalizer Section
@@ -130,42 +179,44 @@ void MainWindow::bindEvents()
             this,
             &MainWindow::equalizerPresetChanged);
     connect(ui->applyEqualizer, &QPushButton::clicked, this, &MainWindow::applyEqualizer);
-    connect(ui->volumelimiterOffButton, &QPushButton::clicked, &API, [=]() {
-        API.setVolumeLimiter(selectedDevice, false);
+    connect(ui->fitEqualizer, &QPushButton::clicked, this, &MainWindow::fitEqualizer);
+    connect(ui->presetLibrary, &QPushButton::clicked, this, &MainWindow::openPresetLibrary);
+    connect(ui->volumelimiterOffButton, &QPushButton::clicked, API, [=]() {
+        API->setVolumeLimiter(false);
     });
-    connect(ui->volumelimiterOnButton, &QPushButton::clicked, &API, [=]() {
-        API.setVolumeLimiter(selectedDevice, true);
+    connect(ui->volumelimiterOnButton, &QPushButton::clicked, API, [=]() {
+        API->setVolumeLimiter(true);
     });
 
     // Microphone Section
-    connect(ui->muteledbrightnessSlider, &QSlider::sliderReleased, &API, [=]() {
-        API.setMuteLedBrightness(selectedDevice, ui->muteledbrightnessSlider->value());
+    connect(ui->muteledbrightnessSlider, &QSlider::valueChanged, API, [=](int value) {
+        API->setMuteLedBrightness(value);
     });
-    connect(ui->micvolumeSlider, &QSlider::sliderReleased, &API, [=]() {
-        API.setMicrophoneVolume(selectedDevice, ui->micvolumeSlider->value());
+    connect(ui->micvolumeSlider, &QSlider::valueChanged, API, [=](int value) {
+        API->setMicrophoneVolume(value);
     });
-    connect(ui->rotateOn, &QPushButton::clicked, &API, [=]() {
-        API.setRotateToMute(selectedDevice, true);
+    connect(ui->rotateOn, &QPushButton::clicked, API, [=]() {
+        API->setRotateToMute(true);
     });
-    connect(ui->rotateOff, &QPushButton::clicked, &API, [=]() {
-        API.setRotateToMute(selectedDevice, false);
+    connect(ui->rotateOff, &QPushButton::clicked, API, [=]() {
+        API->setRotateToMute(false);
     });
 
     // Bluetooth Section
-    connect(ui->btwhenonOffButton, &QPushButton::clicked, &API, [=]() {
-        API.setBluetoothWhenPoweredOn(selectedDevice, false);
+    connect(ui->btwhenonOffButton, &QPushButton::clicked, API, [=]() {
+        API->setBluetoothWhenPoweredOn(false);
     });
-    connect(ui->btwhenonOnButton, &QPushButton::clicked, &API, [=]() {
-        API.setBluetoothWhenPoweredOn(selectedDevice, true);
+    connect(ui->btwhenonOnButton, &QPushButton::clicked, API, [=]() {
+        API->setBluetoothWhenPoweredOn(true);
     });
-    connect(ui->btbothRadioButton, &QRadioButton::clicked, &API, [=]() {
-        API.setBluetoothCallVolume(selectedDevice, 0);
+    connect(ui->btbothRadioButton, &QRadioButton::clicked, API, [=]() {
+        API->setBluetoothCallVolume(0);
     });
-    connect(ui->btpcdbRadioButton, &QRadioButton::clicked, &API, [=]() {
-        API.setBluetoothCallVolume(selectedDevice, 1);
+    connect(ui->btpcdbRadioButton, &QRadioButton::clicked, API, [=]() {
+        API->setBluetoothCallVolume(1);
     });
-    connect(ui->btonlyRadioButton, &QRadioButton::clicked, &API, [=]() {
-        API.setBluetoothCallVolume(selectedDevice, 2);
+    connect(ui->btonlyRadioButton, &QRadioButton::clicked, API, [=]() {
+        API->setBluetoothCallVolume(2);
     });
 }
 
@@ -182,11 +233,11 @@ void MainWindow::setupTrayIcon()
     trayIcon->setToolTip("HeadsetControl");
 
     trayMenu->addAction(tr("Hide/Show"), this, &MainWindow::toggleWindow);
-    ledOn = trayMenu->addAction(tr("Turn Lights On"), &API, [=]() {
-        API.setLights(selectedDevice, true);
+    ledOn = trayMenu->addAction(tr("Turn Lights On"), API, [=]() {
+        API->setLights(true);
     });
-    ledOff = trayMenu->addAction(tr("Turn Lights Off"), &API, [=]() {
-        API.setLights(selectedDevice, false);
+    ledOff = trayMenu->addAction(tr("Turn Lights Off"), API, [=]() {
+        API->setLights(false);
     });
     trayMenu->addAction(tr("Exit"), this, &QApplication::quit);
 
@@ -227,16 +278,13 @@ void MainWindow::updateIconsTheme()
 
 void MainWindow::updateStyle()
 {
-    if (settings.styleName != "Default") {
-        QString destination = PROGRAM_STYLES_PATH + "/" + settings.styleName;
-        QFile file(destination);
-        if (file.open(QFile::ReadOnly)) {
-            QString styleSheet = QLatin1String(file.readAll());
-            setStyleSheet(styleSheet);
-        }
-    } else {
-        setStyleSheet(defaultStyle);
-    }
+    // Only re-polishes through styleSheetChanged() when the stylesheet text differs
+    styleManager->setActiveStyle(settings.styleName);
+}
+
+void MainWindow::applyStyleSheet(const QString &styleSheet)
+{
+    setStyleSheet(styleSheet.isEmpty() ? defaultStyle : styleSheet);
     minimizeWindowSize();
     moveToBottomRight();
 }
@@ -298,7 +346,8 @@ void MainWindow::resetGUI()
     ui->equalizerpresetFrame->setHidden(true);
     ui->equalizerFrame->setHidden(true);
     ui->applyEqualizer->setEnabled(false);
-    clearEqualizerSliders(ui->equalizerLayout);
+    ui->fitEqualizer->setEnabled(false);
+    ui->presetLibrary->setEnabled(false);
 
     ui->rotatetomuteFrame->setHidden(true);
     ui->muteledbrightnessFrame->setHidden(true);
@@ -317,26 +366,47 @@ void MainWindow::sendAppNotification(const QString &title,
 }
 
 //Devices Managing Section
-void MainWindow::loadDevices()
+QFuture<void> MainWindow::loadDevices()
 {
-    deleteDevices(connectedDevices);
-    QList<Device *> saved = getSavedDevices();
-    connectedDevices = API.getConnectedDevices();
-    updateDevicesFromSource(connectedDevices, saved);
+    // selectDevice() and the poll timer can ask while an enumeration is running
+    if (devicesLoading.isRunning()) {
+        return devicesLoading;
+    }
+    devicesLoading = API->getConnectedDevices().then(this, [this](QList<Device> devices) {
+        // selectedDevice points into the store about to be refilled: carry the
+        // selection over when the same unit is still at the same position
+        DeviceStore::Handle selected = DeviceStore::InvalidHandle;
+        DeviceKey selectedKey;
+        if (selectedDevice != nullptr) {
+            selectedKey = selectedDevice->key();
+            selected = connectedDevices.find(selectedKey);
+        }
+        selectedDevice = nullptr;
+
+        updateDevicesFromSource(devices, getSavedDevices(), false);
+        connectedDevices.assign(devices);
 
-    deleteDevices(saved);
+        if (selected != DeviceStore::InvalidHandle
+            && connectedDevices.find(selectedKey) == selected) {
+            selectedDevice = connectedDevices.get(selected);
+        } else {
+            API->stopFollowing();
+        }
+    });
+    return devicesLoading;
 }
 
-void MainWindow::loadDevice(int deviceIndex)
+void MainWindow::loadDevice(int deviceIndex, bool restoreSettings)
 {
     resetGUI();
+    inputReportListener.stop();
 
     if (deviceIndex < 0) {
         selectedDevice = nullptr;
         return;
     }
 
-    selectedDevice = connectedDevices.value(deviceIndex);
+    selectedDevice = connectedDevices.get(deviceIndex);
     QSet<QString> &capabilities = selectedDevice->capabilities;
 
     ui->missingheadsetcontrolFrame->setHidden(true);
@@ -421,6 +491,27 @@ void MainWindow::loadDevice(int deviceIndex)
     loadGUIValues();
     minimizeWindowSize();
     moveToBottomRight();
+
+    // Commands always reach the first device, so only it gets its saved profile back.
+    // Re-enumerations and hotplug events load it again too: past the first time, what
+    // the headset reports wins over the profile, as it may have been changed elsewhere.
+    bool firstConnect = !restoredDevices.contains(selectedDevice->key());
+    if (deviceIndex == 0 && (restoreSettings || firstConnect)) {
+        restoredDevices.insert(selectedDevice->key());
+        API->restoreDeviceSettings(*selectedDevice);
+    }
+
+    followDevice(qMax(1, settings.msecUpdateIntervalTime / 1000));
+    startInputReportListener();
+}
+
+void MainWindow::startInputReportListener()
+{
+    if (settings.listenInputReports && selectedDevice != nullptr) {
+        inputReportListener.startDevice(selectedDevice->id_vendor, selectedDevice->id_product);
+    } else {
+        inputReportListener.stop();
+    }
 }
 
 void MainWindow::loadGUIValues()
@@ -429,6 +520,12 @@ void MainWindow::loadGUIValues()
         ui->onlightButton->setChecked(selectedDevice->lights);
         ui->offlightButton->setChecked(!selectedDevice->lights);
     }
+    // Sliders stream their values live, so restoring them must not echo back to the device
+    const QSignalBlocker sidetoneBlocker(ui->sidetoneSlider);
+    const QSignalBlocker inactivityBlocker(ui->inactivitySlider);
+    const QSignalBlocker muteledbrightnessBlocker(ui->muteledbrightnessSlider);
+    const QSignalBlocker micvolumeBlocker(ui->micvolumeSlider);
+
     if (selectedDevice->sidetone >= 0) {
         ui->sidetoneSlider->setSliderPosition(selectedDevice->sidetone);
     }
@@ -440,9 +537,7 @@ void MainWindow::loadGUIValues()
         ui->inactivitySlider->setSliderPosition(selectedDevice->inactive_time);
     }
 
-    QHBoxLayout *equalizerLayout = ui->equalizerLayout;
-    clearEqualizerSliders(equalizerLayout);
-    createEqualizerSliders(equalizerLayout);
+    configureEqualizerSliders(ui->equalizerLayout);
 
     ui->equalizerPresetcomboBox->clear();
     for (int i = 0; i < selectedDevice->presets_list.size(); ++i) {
@@ -492,52 +587,162 @@ void MainWindow::loadGUIValues()
     }
 }
 
+void MainWindow::settingApplied(const QString &capability, const QVariant &value)
+{
+    // Commands always reach the first device
+    Device *device = connectedDevices.get(0);
+    if (device != nullptr) {
+        device->applySetting(capability, value);
+    }
+}
+
 void MainWindow::saveDevicesSettings()
 {
-    QList<Device *> toSave = getSavedDevices();
-    updateDevicesFromSource(toSave, connectedDevices);
+    savedDevices->update(connectedDevices.toList());
+}
 
-    serializeDevices(toSave, DEVICES_SETTINGS_FILEPATH);
+const QList<Device> &MainWindow::getSavedDevices() const
+{
+    return savedDevices->devices();
+}
 
-    deleteDevices(toSave);
+void MainWindow::updateDevice(const QList<DeviceStatus> &statuses)
+{
+    // A device that went away is picked up again by the next full enumeration
+    if (selectedDevice != nullptr && !selectedDevice->updateStatus(statuses)) {
+        selectedDevice = nullptr;
+        enumerationNeeded = true;
+        API->stopFollowing();
+        inputReportListener.stop();
+    }
 }
 
-QList<Device *> MainWindow::getSavedDevices()
+void MainWindow::statusUpdated()
 {
-    return deserializeDevices(DEVICES_SETTINGS_FILEPATH);
+    // Reports that queued up meanwhile are all covered by the latest snapshot
+    std::shared_ptr<const DeviceState> state = API->getState();
+    if (state->sequence != appliedStateSequence) {
+        appliedStateSequence = state->sequence;
+        updateDevice(state->statuses);
+    }
+    updateStatusGUI();
 }
 
-void MainWindow::updateDevice()
+void MainWindow::inputReportDecoded(const ReportUpdate &update)
 {
-    QList<Device *> newDl = API.getConnectedDevices();
-    if (!selectedDevice->updateDevice(newDl)) {
-        selectedDevice = nullptr;
+    if (selectedDevice == nullptr) {
+        return;
+    }
+    if (update.has_battery && selectedDevice->capabilities.contains("CAP_BATTERY_STATUS")) {
+        selectedDevice->battery = update.battery;
+        setBatteryStatus();
+    }
+    if (update.has_chatmix && selectedDevice->capabilities.contains("CAP_CHATMIX_STATUS")) {
+        selectedDevice->chatmix = update.chatmix;
+        setChatmixStatus();
     }
+}
 
-    deleteDevices(newDl);
+void MainWindow::hotplugDetected()
+{
+    enumerationNeeded = true;
+    pollScheduler.reset();
+    updateGUI();
 }
 
 //Update GUI Section
 void MainWindow::updateGUI()
 {
-    if (!fileExists(HEADSETCONTROL_FILE_PATH)) {
+    if (!API->isAvailable()) {
+        API->stopFollowing();
         resetGUI();
         ui->notSupportedFrame->setHidden(true);
         selectedDevice = nullptr;
-    } else {
-        if (selectedDevice == nullptr) {
-            loadDevices();
-            if (connectedDevices.isEmpty()) {
-                ui->missingheadsetcontrolFrame->setHidden(true);
-            } else {
-                loadDevice();
-            }
-        } else {
-            updateDevice();
+        updateStatusGUI();
+        return;
+    }
+    // A slow headset must not pile up overlapping polls
+    if (pollInProgress) {
+        return;
+    }
+    // The selected device only needs its status refreshed, and not even that
+    // while the follow stream is pushing it, unless another headset came or went
+    if (selectedDevice != nullptr && !enumerationNeeded) {
+        if (!API->isFollowing()) {
+            // The GUI is refreshed by the statusUpdated() signal the poll emits, the
+            // future only tells when the next poll may start
+            pollInProgress = true;
+            API->getStatus()
+                .then(this, [this](const QList<DeviceStatus> &) { pollInProgress = false; })
+                .onCanceled(this, [this]() { pollInProgress = false; });
         }
+        return;
     }
+    // Without a device there is nothing to refresh until a HID node comes or goes
+    if (hotplugMonitor.isAvailable() && !enumerationNeeded) {
+        return;
+    }
+
+    // loadDevices() keeps the selection only while the unit stays at its position
+    bool hadSelection = selectedDevice != nullptr;
+    DeviceKey selectedKey = hadSelection ? selectedDevice->key() : DeviceKey();
+    enumerationNeeded = false;
+    pollInProgress = true;
+    loadDevices().then(this, [this, hadSelection, selectedKey]() {
+        if (connectedDevices.isEmpty()) {
+            ui->missingheadsetcontrolFrame->setHidden(true);
+        } else if (selectedDevice == nullptr) {
+            DeviceStore::Handle moved = hadSelection ? connectedDevices.find(selectedKey)
+                                                     : DeviceStore::InvalidHandle;
+            loadDevice(moved != DeviceStore::InvalidHandle ? moved : 0);
+        }
+        pollInProgress = false;
+        updateStatusGUI();
+    });
+}
+
+void MainWindow::updateStatusGUI()
+{
     setBatteryStatus();
     setChatmixStatus();
+    scheduleNextUpdate();
+    StartupTimeline::instance().finish("first device update");
+}
+
+void MainWindow::applyPollSettings()
+{
+    pollScheduler.setIntervals(settings.msecMinUpdateIntervalTime,
+                               settings.msecUpdateIntervalTime,
+                               settings.msecMaxUpdateIntervalTime);
+    pollScheduler.setBatteryLowThreshold(settings.batteryLowThreshold);
+}
+
+void MainWindow::scheduleNextUpdate()
+{
+    int msec = pollScheduler.nextInterval(selectedDevice, !connectedDevices.isEmpty());
+    // Idle with no headset: the hotplug monitor wakes us up, no timer needed
+    if (selectedDevice == nullptr && API->isAvailable() && hotplugMonitor.isAvailable()
+        && !enumerationNeeded) {
+        timerGUI->stop();
+        return;
+    }
+    timerGUI->start(msec);
+
+    // Each change of interval respawns the follow stream, so it only follows
+    // the scheduler when the rate is off by at least a factor of two and the
+    // stream has been running for a while; otherwise it keeps its rate
+    int seconds = qMax(1, msec / 1000);
+    bool farOff = seconds >= 2 * followSeconds || 2 * seconds <= followSeconds;
+    if (API->isFollowing() && farOff && followClock.hasExpired(MSEC_MIN_FOLLOW_RESTART)) {
+        followDevice(seconds);
+    }
+}
+
+void MainWindow::followDevice(int secondsInterval)
+{
+    followSeconds = secondsInterval;
+    followClock.start();
+    API->startFollowing(secondsInterval);
 }
 
 // Info Section Events
@@ -572,7 +777,7 @@ void MainWindow::setBatteryStatus()
                                 tr("The battery has been charged to 100%"),
                                 QIcon("battery-level-full"));
             if (settings.audioNotification) {
-                API.playNotificationSound(selectedDevice, 1);
+                API->playNotificationSound(1);
             }
             notified = true;
         }
@@ -592,7 +797,7 @@ void MainWindow::setBatteryStatus()
                                     tr("The battery of your headset is running low"),
                                     QIcon("battery-low"));
                 if (settings.audioNotification) {
-                    API.playNotificationSound(selectedDevice, 0);
+                    API->playNotificationSound(0);
                 }
                 notified = true;
             }
@@ -629,54 +834,90 @@ void MainWindow::equalizerPresetChanged()
 {
     int index = ui->equalizerPresetcomboBox->currentIndex();
     setEqualizerSliders(selectedDevice->presets_list.value(index).values);
-    API.setEqualizerPreset(selectedDevice, index);
+    API->setEqualizerPreset(index);
 }
 
 void MainWindow::applyEqualizer()
 {
     ui->equalizerPresetcomboBox->setCurrentIndex(-1);
     QList<double> values;
-    for (QSlider *slider : slidersEq) {
+    for (QSlider *slider : equalizerSliders.sliders()) {
         values.append(slider->value() * selectedDevice->equalizer.band_step);
     }
-    API.setEqualizer(selectedDevice, values);
+    API->setEqualizer(values);
 }
 
-//Equalizer Slidesrs Section
-void MainWindow::createEqualizerSliders(QHBoxLayout *layout)
-{
-    if (selectedDevice->equalizer.bands_number > 0) {
-        int i;
-        for (i = 0; i < selectedDevice->equalizer.bands_number; ++i) {
-            QLabel *l = new QLabel(QString::number(i));
-            l->setAlignment(Qt::AlignHCenter);
-
-            QSlider *s = new QSlider(Qt::Vertical);
-            s->setMaximum(selectedDevice->equalizer.band_max / selectedDevice->equalizer.band_step);
-            s->setMinimum(selectedDevice->equalizer.band_min / selectedDevice->equalizer.band_step);
-            s->setSingleStep(1);
-            s->setTickInterval(1 / selectedDevice->equalizer.band_step);
-            s->setTickPosition(QSlider::TicksBothSides);
-            if (selectedDevice->equalizer_curve.size() == selectedDevice->equalizer.bands_number) {
-                s->setValue(selectedDevice->equalizer_curve.value(i));
-            } else {
-                s->setValue(selectedDevice->equalizer.band_baseline);
-            }
+void MainWindow::fitEqualizer()
+{
+    if (selectedDevice == nullptr) {
+        return;
+    }
+    DeviceKey device = selectedDevice->key();
+    QString filePath = QFileDialog::getOpenFileName(this,
+                                                    tr("Target Curve"),
+                                                    QString(),
+                                                    tr("Frequency response (*.csv *.txt)"));
+    if (filePath.isEmpty() || !isStillSelected(device)) {
+        return;
+    }
 
-            QVBoxLayout *lb = new QVBoxLayout();
-            lb->addWidget(l);
-            lb->addWidget(s);
+    applyEqualizerCurve(EqualizerFit::loadCurve(filePath), filePath);
+}
 
-            slidersEq.append(s);
-            layout->addLayout(lb);
+void MainWindow::openPresetLibrary()
+{
+    if (selectedDevice == nullptr) {
+        return;
+    }
+    DeviceKey device = selectedDevice->key();
+    PresetLibraryWindow *libraryW = new PresetLibraryWindow(presetLibrary.get(), this);
+    if (libraryW->exec() == QDialog::Accepted && isStillSelected(device)) {
+        PresetLibrary::Entry entry = libraryW->getSelectedPreset();
+        if (entry.format != PresetLibrary::Unknown) {
+            applyEqualizerCurve(PresetLibrary::loadPreset(entry), entry.filePath);
         }
-        ui->applyEqualizer->setEnabled(true);
     }
+    delete libraryW;
+}
+
+void MainWindow::applyEqualizerCurve(const QList<EqualizerFit::CurvePoint> &curve,
+                                     const QString &source)
+{
+    if (selectedDevice == nullptr) {
+        return;
+    }
+    double rmsError = 0;
+    QList<double> values = EqualizerFit(selectedDevice->equalizer).fit(curve, &rmsError);
+    if (values.isEmpty()) {
+        qDebug() << "ERROR: No usable frequency response in" << source;
+        return;
+    }
+    qDebug() << "Equalizer fitted, remaining error" << rmsError << "dB";
+
+    ui->equalizerPresetcomboBox->setCurrentIndex(-1);
+    setEqualizerSliders(values);
+    API->setEqualizer(values);
+}
+
+bool MainWindow::isStillSelected(const DeviceKey &key) const
+{
+    return selectedDevice != nullptr && selectedDevice->key() == key;
+}
+
+//Equalizer Slidesrs Section
+void MainWindow::configureEqualizerSliders(QHBoxLayout *layout)
+{
+    const Equalizer &equalizer = selectedDevice->equalizer;
+    equalizerSliders.configure(layout, equalizer, selectedDevice->equalizer_curve);
+
+    ui->applyEqualizer->setEnabled(!equalizerSliders.isEmpty());
+    ui->fitEqualizer->setEnabled(!equalizerSliders.isEmpty() && equalizer.band_step > 0);
+    ui->presetLibrary->setEnabled(ui->fitEqualizer->isEnabled());
 }
 
 void MainWindow::setEqualizerSliders(double value)
 {
-    for (QSlider *slider : slidersEq) {
+    for (QSlider *slider : equalizerSliders.sliders()) {
         slider->setValue(value / selectedDevice->equalizer.band_step);
     }
 }
@@ -685,7 +926,7 @@ void MainWindow::setEqualizerSliders(QList<double> values)
 {
     int i = 0;
     if (values.length() == selectedDevice->equalizer.bands_number) {
-        for (QSlider *slider : slidersEq) {
+        for (QSlider *slider : equalizerSliders.sliders()) {
             slider->setValue((int) (values[i++] / selectedDevice->equalizer.band_step));
         }
     } else {
@@ -693,32 +934,27 @@ void MainWindow::setEqualizerSliders(QList<double> values)
     }
 }
 
-void MainWindow::clearEqualizerSliders(QLayout *layout)
-{
-    QLayoutItem *item;
-    while (!layout->isEmpty()) {
-        item = layout->takeAt(0);
-        delete item->widget();
-        delete item;
-        slidersEq.removeFirst();
-    }
-}
-
 // Tool Bar Events
 void MainWindow::selectDevice()
 {
-    this->loadDevices();
+    // Open straight away with the devices we already know and refresh them in the background
+    LoaddeviceWindow *loadDevWindow = new LoaddeviceWindow(connectedDevices.toList(), this);
+    QPointer<LoaddeviceWindow> window = loadDevWindow;
+    this->loadDevices().then(this, [this, window]() {
+        if (window) {
+            window->setDevices(connectedDevices.toList());
+        }
+    });
 
-    LoaddeviceWindow *loadDevWindow = new LoaddeviceWindow(connectedDevices, this);
     if (loadDevWindow->exec() == QDialog::Accepted) {
         int index = loadDevWindow->getDeviceIndex();
-        if (index >= 0 && index < connectedDevices.length()) {
+        if (index >= 0 && index < connectedDevices.size()) {
             if (index == 0) {
                 ui->tabWidget->setDisabled(false);
             } else {
                 ui->tabWidget->setDisabled(true);
             }
-            loadDevice(index);
+            loadDevice(index, true);
         }
     }
     delete (loadDevWindow);
@@ -726,24 +962,39 @@ void MainWindow::selectDevice()
 
 void MainWindow::editProgramSetting()
 {
-    SettingsWindow *settingsW = new SettingsWindow(settings, this);
+    SettingsWindow *settingsW = new SettingsWindow(settings, styleManager.get(), this);
     if (settingsW->exec() == QDialog::Accepted) {
         settings = settingsW->getSettings();
         saveSettingstoFile(settings, PROGRAM_SETTINGS_FILEPATH);
-        timerGUI->setInterval(settings.msecUpdateIntervalTime);
+        savedDevices->setBinary(settings.binaryConfig);
+        API->setCommandInterval(settings.msecCommandIntervalTime);
+        applyPollSettings();
+        startInputReportListener();
+        pollScheduler.reset();
+        scheduleNextUpdate();
         updateStyle();
     }
     delete (settingsW);
 }
 
 void MainWindow::checkForUpdates(bool firstStart)
+{
+    // Both lookups run at once; the dialog waits for the second
+    QFuture<QString> hcVersion = updateChecker->latestVersion("Sapd", "HeadsetControl");
+    QFuture<QString> guiVersion = updateChecker->latestVersion("LeoKlaus", "HeadsetControl-GUI");
+    hcVersion.then(this, [this, guiVersion, firstStart](const QString &v1) mutable {
+        guiVersion.then(this, [this, v1, firstStart](const QString &v2) {
+            showUpdates(v1, v2, firstStart);
+        });
+    });
+}
+
+void MainWindow::showUpdates(const QString &v1, const QString &v2, bool firstStart)
 {
     bool needsUpdate = false;
 
-    const QVersionNumber &local_hc = API.getVersion();
+    const QVersionNumber &local_hc = API->getVersion();
     const QVersionNumber local_gui = QVersionNumber::fromString(qApp->applicationVersion());
-    QString v1 = getLatestGitHubReleaseVersion("Sapd", "HeadsetControl");
-    QString v2 = getLatestGitHubReleaseVersion("LeoKlaus", "HeadsetControl-GUI");
     QVersionNumber remote_hc = QVersionNumber::fromString(v1);
     QVersionNumber remote_gui = QVersionNumber::fromString(v2);
     QString s1 = tr("up-to date v") + local_hc.toString();
@@ -2,19 +2,33 @@
 #define MAINWINDOW_H
 
 #include "device.h"
+#include "devicesettingsstore.h"
+#include "devicestore.h"
+#include "equalizersliders.h"
 #include "headsetcontrolapi.h"
+#include "hotplugmonitor.h"
+#include "inputreportlistener.h"
+#include "pollscheduler.h"
+#include "presetlibrary.h"
 #include "settings.h"
+#include "stylemanager.h"
+#include "updatechecker.h"
 
+#include <QElapsedTimer>
 #include <QHBoxLayout>
+#include <QFuture>
 #include <QJsonArray>
 #include <QJsonObject>
 #include <QMainWindow>
 #include <QSlider>
 #include <QStandardPaths>
 #include <QSystemTrayIcon>
+#include <QThread>
 #include <QTimer>
 #include <QVersionNumber>
 
+#include <memory>
+
 QT_BEGIN_NAMESPACE
 namespace Ui {
 class MainWindow;
@@ -39,6 +53,15 @@ public:
 private:
     bool firstShow = true;
     bool notified = false;
+    bool pollInProgress = false;
+    bool enumerationNeeded = true;
+    // Sequence of the API state last applied to the devices
+    quint64 appliedStateSequence = 0;
+
+    static constexpr int MSEC_MIN_FOLLOW_RESTART = 60000;
+    // Rate of the running follow stream, and how long it has been running at it
+    int followSeconds = 0;
+    QElapsedTimer followClock;
 
     QString defaultStyle;
 
@@ -49,20 +72,36 @@ private:
     QAction *ledOn;
     QAction *ledOff;
     QTimer *timerGUI;
+    PollScheduler pollScheduler;
+    HotplugMonitor hotplugMonitor;
+    InputReportListener inputReportListener;
 
     Settings settings;
 
     int n_connected = 0, n_saved = 0;
 
-    HeadsetControlAPI API;
+    // Lives on apiThread: talk to it through its thread-safe methods only
+    HeadsetControlAPI *API;
+    QThread apiThread;
+    // Points into connectedDevices, refreshed whenever the store is
     Device *selectedDevice = nullptr;
-    QList<Device *> connectedDevices;
+    DeviceStore connectedDevices;
+    // These four read their files when constructed, so startDeferredStages() creates them
+    std::unique_ptr<DeviceSettingsStore> savedDevices;
+    // Units that already got their saved profile back this session
+    QSet<DeviceKey> restoredDevices;
+    // The enumeration in flight, shared by everyone asking meanwhile
+    QFuture<void> devicesLoading;
 
-    QList<QSlider *> slidersEq;
+    std::unique_ptr<UpdateChecker> updateChecker;
+    std::unique_ptr<StyleManager> styleManager;
+    std::unique_ptr<PresetLibrary> presetLibrary;
+
+    EqualizerSliders equalizerSliders;
 
-    void deleteDevices(QList<Device *> deviceList);
 
     void bindEvents();
+    void startDeferredStages();
 
     //Tray Icon Section
     void changeTrayIconTo(QString iconName);
@@ -83,43 +122,62 @@ private:
     //Utility
     void sendAppNotification(const QString &title, const QString &description, const QIcon &icon);
 
+    //Update GUI Section
+    void applyPollSettings();
+    void startInputReportListener();
+    void scheduleNextUpdate();
+    void followDevice(int secondsInterval);
+
     //Devices Managing Section
-    void updateDevice();
-    void loadDevice(int deviceIndex = 0);
-    void loadDevices();
+    void updateDevice(const QList<DeviceStatus> &statuses);
+    void loadDevice(int deviceIndex = 0, bool restoreSettings = false);
+    QFuture<void> loadDevices();
     void loadGUIValues();
-    QList<Device *> getSavedDevices();
+    const QList<Device> &getSavedDevices() const;
 
     // Info Section Events
     void setBatteryStatus();
     void setChatmixStatus();
 
     //Equalizer Slidesrs Section
-    void createEqualizerSliders(QHBoxLayout *layout);
+    void configureEqualizerSliders(QHBoxLayout *layout);
     void setEqualizerSliders(double value);
     void setEqualizerSliders(QList<double> values);
-    void clearEqualizerSliders(QLayout *layout);
 
 private slots:
     void changeEvent(QEvent *e);
 
+    //Theme mode Section
+    void applyStyleSheet(const QString &styleSheet);
+
     //Tray Icon Section
     void trayIconActivated(QSystemTrayIcon::ActivationReason reason);
 
     //Devices Managing Section
+    void settingApplied(const QString &capability, const QVariant &value);
     void saveDevicesSettings();
+    void statusUpdated();
+    void hotplugDetected();
+    void inputReportDecoded(const ReportUpdate &update);
 
     //Update GUI Section
     void updateGUI();
+    void updateStatusGUI();
 
     // Equalizer Section Events
     void equalizerPresetChanged();
     void applyEqualizer();
+    void fitEqualizer();
+    void openPresetLibrary();
+    void applyEqualizerCurve(const QList<EqualizerFit::CurvePoint> &curve, const QString &source);
+    // Dialogs run their own event loop, in which polls can replace or drop selectedDevice
+    bool isStillSelected(const DeviceKey &key) const;
 
     // Tool Bar Events
     void selectDevice();
     void editProgramSetting();
     void checkForUpdates(bool firstStart = false);
+    void showUpdates(const QString &v1, const QString &v2, bool firstStart);
     void showAbout();
     void showCredits();
 };
@@ -0,0 +1,105 @@
+#include "presetlibrarywindow.h"
+#include "ui_presetlibrarywindow.h"
+
+#include <QFileDialog>
+#include <QtConcurrent/QtConcurrent>
+
+PresetLibraryWindow::PresetLibraryWindow(PresetLibrary *library, QWidget *parent)
+    : QDialog(parent)
+    , ui(new Ui::presetlibrarywindow)
+    , library(library)
+{
+    setModal(true);
+    ui->setupUi(this);
+
+    connect(ui->browsePushButton, &QPushButton::clicked, this, &PresetLibraryWindow::browse);
+    connect(ui->rescanPushButton, &QPushButton::clicked, this, &PresetLibraryWindow::rescan);
+    connect(ui->searchLineEdit, &QLineEdit::textChanged, this, &PresetLibraryWindow::search);
+    connect(ui->presetsListWidget, &QListWidget::itemDoubleClicked, this, &QDialog::accept);
+
+    ui->libraryPathLineEdit->setText(library->getRoot());
+    search(QString());
+}
+
+PresetLibrary::Entry PresetLibraryWindow::getSelectedPreset()
+{
+    return results.value(ui->presetsListWidget->currentRow());
+}
+
+void PresetLibraryWindow::browse()
+{
+    QString root = QFileDialog::getExistingDirectory(this,
+                                                     tr("Preset Library Folder"),
+                                                     library->getRoot());
+    if (!root.isEmpty()) {
+        ui->libraryPathLineEdit->setText(root);
+        rescan();
+    }
+}
+
+void PresetLibraryWindow::rescan()
+{
+    QString root = ui->libraryPathLineEdit->text();
+    if (root.isEmpty() || scanning.isRunning()) {
+        return;
+    }
+    // Reading a large tree takes seconds; meanwhile searches use the old index
+    PresetLibrary *library = this->library;
+    scanning = QtConcurrent::run([library, root]() { return library->build(root); });
+    setScanning(true);
+    scanning.then(this, [this](bool built) {
+        if (built) {
+            library->publish();
+        }
+        setScanning(false);
+        search(ui->searchLineEdit->text());
+    });
+}
+
+void PresetLibraryWindow::setScanning(bool running)
+{
+    ui->browsePushButton->setEnabled(!running);
+    ui->rescanPushButton->setEnabled(!running);
+    if (running) {
+        setCursor(Qt::BusyCursor);
+    } else {
+        unsetCursor();
+    }
+    updateStatus();
+}
+
+void PresetLibraryWindow::search(const QString &text)
+{
+    // Every keystroke only costs a lookup in the mapped index
+    results = library->search(text);
+    ui->presetsListWidget->clear();
+    for (const PresetLibrary::Entry &entry : std::as_const(results)) {
+        ui->presetsListWidget->addItem(entry.model == entry.name
+                                           ? entry.name
+                                           : entry.model + " - " + entry.name);
+    }
+    if (!results.isEmpty()) {
+        ui->presetsListWidget->setCurrentRow(0);
+    }
+    updateStatus();
+}
+
+void PresetLibraryWindow::updateStatus()
+{
+    if (scanning.isRunning()) {
+        ui->statusLabel->setText(tr("Indexing presets..."));
+    } else if (library->getRoot().isEmpty()) {
+        ui->statusLabel->setText(tr("Choose a folder of AutoEQ-style presets."));
+    } else {
+        ui->statusLabel->setText(tr("%1 matches, %2 files indexed")
+                                     .arg(results.size())
+                                     .arg(library->size()));
+    }
+}
+
+PresetLibraryWindow::~PresetLibraryWindow()
+{
+    // The build still reads the library, which may go away with the main window
+    scanning.waitForFinished();
+    delete ui;
+}
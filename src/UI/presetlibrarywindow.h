@@ -0,0 +1,38 @@
+#ifndef PRESETLIBRARYWINDOW_H
+#define PRESETLIBRARYWINDOW_H
+
+#include "presetlibrary.h"
+
+#include <QDialog>
+#include <QFuture>
+
+namespace Ui {
+class presetlibrarywindow;
+}
+
+class PresetLibraryWindow : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit PresetLibraryWindow(PresetLibrary *library, QWidget *parent = nullptr);
+    ~PresetLibraryWindow();
+
+    // Entry in Unknown format if nothing is selected
+    PresetLibrary::Entry getSelectedPreset();
+
+private:
+    Ui::presetlibrarywindow *ui;
+    PresetLibrary *library;
+    QList<PresetLibrary::Entry> results;
+    // Index build running on the thread pool
+    QFuture<bool> scanning;
+
+    void browse();
+    void rescan();
+    void setScanning(bool running);
+    void search(const QString &text);
+    void updateStatus();
+};
+
+#endif // PRESETLIBRARYWINDOW_H
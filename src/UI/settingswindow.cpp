@@ -6,9 +6,13 @@
 #include <QFileDialog>
 #include <QStyleHints>
 
-SettingsWindow::SettingsWindow(const Settings &programSettings, QWidget *parent)
+SettingsWindow::SettingsWindow(const Settings &programSettings,
+                               StyleManager *styleManager,
+                               QWidget *parent)
     : QDialog(parent)
     , ui(new Ui::settingswindow)
+    , programSettings(programSettings)
+    , styleManager(styleManager)
 {
     setModal(true);
     ui->setupUi(this);
@@ -18,10 +22,11 @@ SettingsWindow::SettingsWindow(const Settings &programSettings, QWidget *parent)
             &QComboBox::currentTextChanged,
             this,
             [this](const QString &text) {
-                this->ui->removestylePushButton->setEnabled(text != "Default");
+                this->ui->removestylePushButton->setEnabled(text != StyleManager::DEFAULT_STYLE);
             });
     connect(ui->loadstylePushButton, &QPushButton::clicked, this, &SettingsWindow::saveStyle);
     connect(ui->removestylePushButton, &QPushButton::clicked, this, &SettingsWindow::removeStyle);
+    connect(styleManager, &StyleManager::stylesChanged, this, &SettingsWindow::loadStyles);
 
     ui->runonstartupCheckBox->setChecked(programSettings.runOnstartup);
 
@@ -29,9 +34,18 @@ SettingsWindow::SettingsWindow(const Settings &programSettings, QWidget *parent)
     ui->batterylownotificationCheckBox->setChecked(programSettings.notificationBatteryLow);
     ui->batterylowtresholdSpinBox->setValue(programSettings.batteryLowThreshold);
     ui->enableaudioNotificationCheckBox->setChecked(programSettings.audioNotification);
+    ui->listeninputreportsCheckBox->setChecked(programSettings.listenInputReports);
+    ui->binaryconfigCheckBox->setChecked(programSettings.binaryConfig);
 
     ui->updateintervaltimeDoubleSpinBox->setValue((double) programSettings.msecUpdateIntervalTime
                                                   / 1000);
+    ui->minupdateintervaltimeDoubleSpinBox->setValue(
+        (double) programSettings.msecMinUpdateIntervalTime / 1000);
+    ui->maxupdateintervaltimeDoubleSpinBox->setValue(
+        (double) programSettings.msecMaxUpdateIntervalTime / 1000);
+    ui->commandintervaltimeSpinBox->setRange(Settings::MSEC_MIN_COMMAND_INTERVAL,
+                                             Settings::MSEC_MAX_COMMAND_INTERVAL);
+    ui->commandintervaltimeSpinBox->setValue(programSettings.msecCommandIntervalTime);
 
     loadStyles();
     ui->selectstyleComboBox->setCurrentIndex(
@@ -40,13 +54,19 @@ SettingsWindow::SettingsWindow(const Settings &programSettings, QWidget *parent)
 
 Settings SettingsWindow::getSettings()
 {
-    Settings settings;
+    // Start from the current settings so values without a widget are kept
+    Settings settings = programSettings;
     settings.runOnstartup = ui->runonstartupCheckBox->isChecked();
     settings.notificationBatteryFull = ui->batteryfullnotificationCheckBox->isChecked();
     settings.notificationBatteryLow = ui->batterylownotificationCheckBox->isChecked();
     settings.batteryLowThreshold = ui->batterylowtresholdSpinBox->value();
     settings.audioNotification = ui->enableaudioNotificationCheckBox->isChecked();
+    settings.listenInputReports = ui->listeninputreportsCheckBox->isChecked();
+    settings.binaryConfig = ui->binaryconfigCheckBox->isChecked();
     settings.msecUpdateIntervalTime = ui->updateintervaltimeDoubleSpinBox->value() * 1000;
+    settings.msecMinUpdateIntervalTime = ui->minupdateintervaltimeDoubleSpinBox->value() * 1000;
+    settings.msecMaxUpdateIntervalTime = ui->maxupdateintervaltimeDoubleSpinBox->value() * 1000;
+    settings.msecCommandIntervalTime = ui->commandintervaltimeSpinBox->value();
     settings.styleName = ui->selectstyleComboBox->currentText();
 
     return settings;
@@ -60,12 +80,15 @@ void SettingsWindow::setRunOnStartup()
 
 void SettingsWindow::loadStyles()
 {
-    QString destination = PROGRAM_STYLES_PATH;
-    QDir directory = QDir(destination);
-    QStringList list = directory.entryList(QStringList() << "*.qss", QDir::Files);
+    // Keeps the selection when the list changes while the dialog is open
+    QString selected = ui->selectstyleComboBox->currentText();
     ui->selectstyleComboBox->clear();
-    ui->selectstyleComboBox->addItem("Default");
-    ui->selectstyleComboBox->addItems(list);
+    ui->selectstyleComboBox->addItem(StyleManager::DEFAULT_STYLE);
+    ui->selectstyleComboBox->addItems(styleManager->styles());
+    if (!selected.isEmpty()) {
+        ui->selectstyleComboBox->setCurrentIndex(
+            qMax(0, ui->selectstyleComboBox->findText(selected)));
+    }
 }
 
 void SettingsWindow::saveStyle()
@@ -77,7 +100,7 @@ void SettingsWindow::saveStyle()
     QUrl fileUrl = dialog.getOpenFileUrl();
     if (fileUrl.isValid()) {
         QString source = fileUrl.path().removeFirst();
-        QString destination = PROGRAM_STYLES_PATH;
+        QString destination = styleManager->getStylesPath();
         QDir().mkpath(destination);
         destination += "/" + fileUrl.fileName();
         QFile file(destination);
@@ -86,19 +109,20 @@ void SettingsWindow::saveStyle()
         }
         QFile::copy(source, destination);
 
-        loadStyles();
+        styleManager->refresh();
     }
 }
 
 void SettingsWindow::removeStyle()
 {
-    QString stylePath = PROGRAM_STYLES_PATH + "/" + ui->selectstyleComboBox->currentText();
+    QString stylePath = styleManager->getStylesPath() + "/"
+                        + ui->selectstyleComboBox->currentText();
     QFile file(stylePath);
     if (file.exists()) {
         file.remove();
     }
 
-    loadStyles();
+    styleManager->refresh();
 }
 
 SettingsWindow::~SettingsWindow()
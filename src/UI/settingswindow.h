@@ -2,6 +2,7 @@
 #define SETTINGSWINDOW_H
 
 #include "settings.h"
+#include "stylemanager.h"
 
 #include <QDialog>
 
@@ -14,13 +15,17 @@ class SettingsWindow : public QDialog
     Q_OBJECT
 
 public:
-    explicit SettingsWindow(const Settings &programSettings, QWidget *parent = nullptr);
+    explicit SettingsWindow(const Settings &programSettings,
+                            StyleManager *styleManager,
+                            QWidget *parent = nullptr);
     ~SettingsWindow();
 
     Settings getSettings();
 
 private:
     Ui::settingswindow *ui;
+    Settings programSettings;
+    StyleManager *styleManager;
 
     void setRunOnStartup();
     void loadStyles();
@@ -0,0 +1,120 @@
+#include "attachmentcachetransport.h"
+
+#include <hidapi.h>
+
+AttachmentCacheTransport::AttachmentCacheTransport(HeadsetTransport *fallback, QObject *parent)
+    : HeadsetTransport(parent)
+    , fallback(fallback)
+{
+    fallback->setParent(this);
+    initialized = hid_init() == 0;
+
+    connect(fallback, &HeadsetTransport::statusUpdated, this, &HeadsetTransport::statusUpdated);
+}
+
+AttachmentCacheTransport::~AttachmentCacheTransport()
+{
+    if (initialized) {
+        hid_exit();
+    }
+}
+
+bool AttachmentCacheTransport::isAvailable() const
+{
+    return fallback->isAvailable();
+}
+
+QFuture<QList<Device>> AttachmentCacheTransport::enumerate()
+{
+    QSet<quint32> attached = attachedIds();
+    if (!initialized || !enumerated || attached != lastAttached) {
+        return enumerateAll(attached);
+    }
+
+    // Same headsets as last time: identity, capabilities and equalizer layout are
+    // kept, battery, chatmix and status are always read again
+    return fallback->status()
+        .then(this,
+              [this, attached](const QList<DeviceStatus> &statuses) {
+                  QList<Device> devices = knownDevices;
+                  if (!mergeStatuses(devices, statuses)) {
+                      return enumerateAll(attached);
+                  }
+                  return QtFuture::makeReadyValueFuture(devices);
+              })
+        .unwrap();
+}
+
+QFuture<QList<Device>> AttachmentCacheTransport::enumerateAll(const QSet<quint32> &attached)
+{
+    return fallback->enumerate().then(this, [this, attached](const QList<Device> &devices) {
+        knownDevices = devices;
+        lastAttached = attached;
+        enumerated = true;
+        // What gets reported is the headsetcontrol doing the work, hidapi included
+        name = fallback->getName();
+        version = fallback->getVersion();
+        api_version = fallback->getApiVersion();
+        hidapi_version = fallback->getHidApiVersion();
+        return devices;
+    });
+}
+
+QFuture<QList<DeviceStatus>> AttachmentCacheTransport::status()
+{
+    return fallback->status();
+}
+
+QFuture<QList<Action>> AttachmentCacheTransport::apply(const QList<Command> &commands)
+{
+    return fallback->apply(commands);
+}
+
+void AttachmentCacheTransport::startFollowing(int secondsInterval)
+{
+    fallback->startFollowing(secondsInterval);
+}
+
+void AttachmentCacheTransport::stopFollowing()
+{
+    fallback->stopFollowing();
+}
+
+bool AttachmentCacheTransport::isFollowing() const
+{
+    return fallback->isFollowing();
+}
+
+bool AttachmentCacheTransport::mergeStatuses(QList<Device> &devices,
+                                             const QList<DeviceStatus> &statuses)
+{
+    // Both come from headsetcontrol, which lists devices in the same order every time
+    if (devices.length() != statuses.length()) {
+        return false;
+    }
+    for (int i = 0; i < devices.length(); ++i) {
+        const DeviceStatus &status = statuses.at(i);
+        if (devices.at(i).id_vendor != status.id_vendor
+            || devices.at(i).id_product != status.id_product) {
+            return false;
+        }
+        devices[i].updateStatus(status);
+    }
+    return true;
+}
+
+QSet<quint32> AttachmentCacheTransport::attachedIds() const
+{
+    QSet<quint32> ids;
+    if (!initialized) {
+        return ids;
+    }
+
+    hid_device_info *devices = hid_enumerate(0, 0);
+    for (hid_device_info *info = devices; info != nullptr; info = info->next) {
+        ids.insert(quint32(info->vendor_id) << 16 | info->product_id);
+    }
+    hid_free_enumeration(devices);
+
+    return ids;
+}
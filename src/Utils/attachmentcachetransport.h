@@ -0,0 +1,50 @@
+#ifndef ATTACHMENTCACHETRANSPORT_H
+#define ATTACHMENTCACHETRANSPORT_H
+
+#include "headsettransport.h"
+
+#include <QSet>
+
+// Skips headsetcontrol's full enumeration while the same headsets stay attached
+// (qmake CONFIG+=hidapi). hidapi lists the attached VID:PIDs in-process; while that
+// set is unchanged the static device data is kept and only a status read goes to
+// the fallback transport. That read still runs headsetcontrol: its device protocols
+// only exist inside its executable. Commands and follow updates are forwarded to the
+// fallback unchanged, and so are the versions it reports.
+class AttachmentCacheTransport : public HeadsetTransport
+{
+    Q_OBJECT
+
+public:
+    AttachmentCacheTransport(HeadsetTransport *fallback, QObject *parent = nullptr);
+    ~AttachmentCacheTransport();
+
+    bool isAvailable() const override;
+
+    QFuture<QList<Device>> enumerate() override;
+    QFuture<QList<DeviceStatus>> status() override;
+    QFuture<QList<Action>> apply(const QList<Command> &commands) override;
+
+    void startFollowing(int secondsInterval) override;
+    void stopFollowing() override;
+    bool isFollowing() const override;
+
+private:
+    HeadsetTransport *fallback;
+    bool initialized = false;
+    // Until the first full enumeration an empty attached set proves nothing
+    bool enumerated = false;
+
+    // Devices from the last full fallback enumeration, in its order; identical units stay
+    // separate. Only their static fields are reused, see mergeStatuses()
+    QList<Device> knownDevices;
+    // Packed VID:PIDs, as in DeviceKey
+    QSet<quint32> lastAttached;
+
+    QFuture<QList<Device>> enumerateAll(const QSet<quint32> &attached);
+    // Returns false when statuses don't list the same devices, in the same order
+    static bool mergeStatuses(QList<Device> &devices, const QList<DeviceStatus> &statuses);
+    QSet<quint32> attachedIds() const;
+};
+
+#endif // ATTACHMENTCACHETRANSPORT_H
@@ -0,0 +1,334 @@
+#include "equalizerfit.h"
+
+#include <QFile>
+#include <QRegularExpression>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+// This is where nearly all of the fitting time goes. Without -ffast-math the compiler
+// may not reorder a single running sum, so every add would wait for the previous one;
+// four independent sums keep several adds in flight and can share one SIMD register.
+static double dot(const double *a, const double *b, size_t size)
+{
+    double sum0 = 0;
+    double sum1 = 0;
+    double sum2 = 0;
+    double sum3 = 0;
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        sum0 += a[i] * b[i];
+        sum1 += a[i + 1] * b[i + 1];
+        sum2 += a[i + 2] * b[i + 2];
+        sum3 += a[i + 3] * b[i + 3];
+    }
+    for (; i < size; ++i) {
+        sum0 += a[i] * b[i];
+    }
+    return (sum0 + sum1) + (sum2 + sum3);
+}
+
+// Solves matrix x = rhs for a size x size row-major matrix by Gaussian elimination with
+// partial pivoting; false if the matrix is (numerically) singular
+static bool solveLinear(std::vector<double> matrix,
+                        std::vector<double> rhs,
+                        size_t size,
+                        std::vector<double> &x)
+{
+    // Relative to the largest entry, so a pivot lost in rounding counts as zero
+    double scale = 0;
+    for (double value : matrix) {
+        scale = std::max(scale, std::abs(value));
+    }
+    for (size_t column = 0; column < size; ++column) {
+        size_t pivot = column;
+        for (size_t row = column + 1; row < size; ++row) {
+            if (std::abs(matrix[row * size + column]) > std::abs(matrix[pivot * size + column])) {
+                pivot = row;
+            }
+        }
+        if (std::abs(matrix[pivot * size + column]) <= 1e-13 * scale) {
+            return false;
+        }
+        if (pivot != column) {
+            double *pivotRow = &matrix[pivot * size];
+            std::swap_ranges(pivotRow, pivotRow + size, &matrix[column * size]);
+            std::swap(rhs[pivot], rhs[column]);
+        }
+        for (size_t row = column + 1; row < size; ++row) {
+            double factor = matrix[row * size + column] / matrix[column * size + column];
+            for (size_t k = column; k < size; ++k) {
+                matrix[row * size + k] -= factor * matrix[column * size + k];
+            }
+            rhs[row] -= factor * rhs[column];
+        }
+    }
+    x.assign(size, 0);
+    for (size_t row = size; row-- > 0;) {
+        double sum = rhs[row];
+        for (size_t k = row + 1; k < size; ++k) {
+            sum -= matrix[row * size + k] * x[k];
+        }
+        x[row] = sum / matrix[row * size + row];
+    }
+    return true;
+}
+
+// Minimises x' gram x - 2 x' projection with every x within [lower, upper], by an
+// active set method: solve exactly for the free bands with the others held at a bound,
+// pin the ones that overshoot, and free a pinned one whose gradient points inwards.
+// The band responses overlap a lot, which leaves gram too ill-conditioned for
+// coordinate descent to converge in reasonable time.
+static std::vector<double> solveBounded(const std::vector<double> &gram,
+                                        const std::vector<double> &projection,
+                                        double lower,
+                                        double upper)
+{
+    enum Bound { Free, Lower, Upper };
+    const size_t bands = projection.size();
+    std::vector<Bound> bounds(bands, Free);
+    std::vector<double> x(bands, 0.0);
+
+    for (size_t iteration = 0; iteration < 4 * bands + 4; ++iteration) {
+        std::vector<size_t> free;
+        for (size_t i = 0; i < bands; ++i) {
+            if (bounds[i] == Free) {
+                free.push_back(i);
+            } else {
+                x[i] = bounds[i] == Lower ? lower : upper;
+            }
+        }
+
+        if (!free.empty()) {
+            const size_t size = free.size();
+            std::vector<double> matrix(size * size);
+            std::vector<double> rhs(size);
+            for (size_t r = 0; r < size; ++r) {
+                const double *row = &gram[free[r] * bands];
+                rhs[r] = projection[free[r]];
+                for (size_t i = 0; i < bands; ++i) {
+                    if (bounds[i] != Free) {
+                        rhs[r] -= row[i] * x[i];
+                    }
+                }
+                for (size_t c = 0; c < size; ++c) {
+                    matrix[r * size + c] = row[free[c]];
+                }
+            }
+            std::vector<double> solution;
+            if (!solveLinear(std::move(matrix), std::move(rhs), size, solution)) {
+                break;
+            }
+            bool overshot = false;
+            for (size_t r = 0; r < size; ++r) {
+                x[free[r]] = solution[r];
+                if (solution[r] < lower || solution[r] > upper) {
+                    bounds[free[r]] = solution[r] < lower ? Lower : Upper;
+                    overshot = true;
+                }
+            }
+            if (overshot) {
+                continue;
+            }
+        }
+
+        // Optimal unless moving a pinned band off its bound lowers the error
+        size_t release = bands;
+        double steepest = 1e-9;
+        for (size_t i = 0; i < bands; ++i) {
+            double gradient = dot(&gram[i * bands], x.data(), bands) - projection[i];
+            if ((bounds[i] == Lower && -gradient > steepest)
+                || (bounds[i] == Upper && gradient > steepest)) {
+                release = i;
+                steepest = std::abs(gradient);
+            }
+        }
+        if (release == bands) {
+            break;
+        }
+        bounds[release] = Free;
+    }
+
+    for (double &value : x) {
+        value = std::clamp(value, lower, upper);
+    }
+    return x;
+}
+
+EqualizerFit::EqualizerFit(const Equalizer &equalizer)
+    : equalizer(equalizer)
+{
+    int bands = equalizer.bands_number;
+    if (bands <= 0) {
+        return;
+    }
+    if (bands == 1) {
+        frequencies.append(std::sqrt(MIN_FREQUENCY * MAX_FREQUENCY));
+        width = std::log2(MAX_FREQUENCY / MIN_FREQUENCY);
+        return;
+    }
+    width = std::log2(MAX_FREQUENCY / MIN_FREQUENCY) / (bands - 1);
+    for (int i = 0; i < bands; ++i) {
+        frequencies.append(MIN_FREQUENCY * std::exp2(width * i));
+    }
+}
+
+QList<EqualizerFit::CurvePoint> EqualizerFit::loadCurve(const QString &filePath)
+{
+    QList<CurvePoint> curve;
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return curve;
+    }
+
+    QTextStream stream(&file);
+    QString line;
+    while (stream.readLineInto(&line)) {
+        // Accepts comma, semicolon, tab or space separated columns
+        QStringList fields = line.split(QRegularExpression("[,;\\s]+"), Qt::SkipEmptyParts);
+        if (fields.size() < 2) {
+            continue;
+        }
+        bool frequencyOk = false;
+        bool gainOk = false;
+        CurvePoint point;
+        point.frequency = fields.at(0).toDouble(&frequencyOk);
+        point.gain = fields.at(1).toDouble(&gainOk);
+        if (frequencyOk && gainOk && point.frequency > 0) {
+            curve.append(point);
+        }
+    }
+    return curve;
+}
+
+QList<double> EqualizerFit::bandFrequencies() const
+{
+    return frequencies;
+}
+
+double EqualizerFit::bandResponse(int band, double frequency) const
+{
+    double octaves = std::log2(frequency / frequencies.at(band)) / width;
+    return std::exp(-0.5 * octaves * octaves);
+}
+
+double EqualizerFit::residual(const std::vector<double> &gram,
+                              const std::vector<double> &projection,
+                              const std::vector<double> &gains)
+{
+    // |A g - t|^2 - |t|^2 = g' A'A g - 2 g' A't
+    size_t bands = gains.size();
+    double sum = 0;
+    for (size_t i = 0; i < bands; ++i) {
+        sum += gains[i] * (dot(&gram[i * bands], gains.data(), bands) - 2 * projection[i]);
+    }
+    return sum;
+}
+
+QList<double> EqualizerFit::fit(const QList<CurvePoint> &target, double *rmsError) const
+{
+    const size_t bands = frequencies.size();
+    if (bands == 0 || equalizer.band_step <= 0) {
+        return QList<double>();
+    }
+
+    // Only the audible range counts
+    std::vector<double> points;
+    std::vector<double> gains;
+    for (const CurvePoint &point : target) {
+        if (point.frequency >= 20 && point.frequency <= 20000) {
+            points.push_back(point.frequency);
+            gains.push_back(point.gain);
+        }
+    }
+    const size_t size = points.size();
+    if (size == 0) {
+        return QList<double>();
+    }
+
+    // Overall loudness isn't the equalizer's job: with the target and every band
+    // response centred on their mean, the fit is the best one at any level
+    double mean = std::accumulate(gains.begin(), gains.end(), 0.0) / size;
+    for (double &gain : gains) {
+        gain -= mean;
+    }
+
+    // Band responses stored per band, so each column is contiguous
+    std::vector<double> responses(bands * size);
+    for (size_t b = 0; b < bands; ++b) {
+        double *column = &responses[b * size];
+        for (size_t p = 0; p < size; ++p) {
+            column[p] = bandResponse(int(b), points[p]);
+        }
+        double columnMean = std::accumulate(column, column + size, 0.0) / size;
+        for (size_t p = 0; p < size; ++p) {
+            column[p] -= columnMean;
+        }
+    }
+
+    // Normal equations: gram = A'A, projection = A't
+    std::vector<double> gram(bands * bands);
+    std::vector<double> projection(bands);
+    for (size_t i = 0; i < bands; ++i) {
+        const double *column = &responses[i * size];
+        for (size_t j = i; j < bands; ++j) {
+            double value = dot(column, &responses[j * size], size);
+            gram[i * bands + j] = value;
+            gram[j * bands + i] = value;
+        }
+        projection[i] = dot(column, gains.data(), size);
+    }
+
+    // Bounds relative to the flat setting
+    const double step = equalizer.band_step;
+    const double lower = equalizer.band_min - equalizer.band_baseline;
+    const double upper = equalizer.band_max - equalizer.band_baseline;
+
+    std::vector<double> solution = solveBounded(gram, projection, lower, upper);
+
+    // Snap to what the device accepts
+    auto snap = [&](double gain) {
+        double value = std::round((equalizer.band_baseline + gain) / step) * step;
+        return std::clamp(value, (double) equalizer.band_min, (double) equalizer.band_max)
+               - equalizer.band_baseline;
+    };
+    for (double &gain : solution) {
+        gain = snap(gain);
+    }
+
+    // Rounding each band on its own isn't optimal: move single bands by one step
+    // while that still lowers the error
+    bool improved = true;
+    for (size_t pass = 0; improved && pass < 4 * bands; ++pass) {
+        improved = false;
+        for (size_t i = 0; i < bands; ++i) {
+            double gradient = dot(&gram[i * bands], solution.data(), bands) - projection[i];
+            double diagonal = gram[i * bands + i];
+            for (double delta : {step, -step}) {
+                double moved = solution[i] + delta;
+                if (moved < lower - 1e-9 || moved > upper + 1e-9) {
+                    continue;
+                }
+                if (2 * delta * gradient + delta * delta * diagonal < -1e-12) {
+                    solution[i] = moved;
+                    improved = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    if (rmsError != nullptr) {
+        double error = residual(gram, projection, solution) + dot(gains.data(), gains.data(), size);
+        *rmsError = std::sqrt(std::max(0.0, error) / size);
+    }
+
+    QList<double> values;
+    values.reserve(bands);
+    for (double gain : solution) {
+        values.append(equalizer.band_baseline + gain);
+    }
+    return values;
+}
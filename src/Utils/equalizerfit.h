@@ -0,0 +1,55 @@
+#ifndef EQUALIZERFIT_H
+#define EQUALIZERFIT_H
+
+#include "device.h"
+
+#include <QList>
+#include <QString>
+
+#include <vector>
+
+// Finds the equalizer values that best reproduce a target frequency response.
+//
+// headsetcontrol doesn't report where the bands sit, so they are modelled as
+// peaking filters spread evenly on a log scale between MIN_FREQUENCY and
+// MAX_FREQUENCY, each a gaussian bump in octaves as wide as the band spacing.
+// The gains come from a least-squares fit bounded by band_min/band_max, with the
+// overall level left free, then snapped to band_step and refined on that grid.
+class EqualizerFit
+{
+public:
+    class CurvePoint
+    {
+    public:
+        double frequency;
+        double gain;
+    };
+
+    static constexpr double MIN_FREQUENCY = 31.25;
+    static constexpr double MAX_FREQUENCY = 16000;
+
+    explicit EqualizerFit(const Equalizer &equalizer);
+
+    // Reads "frequency,dB" lines; header, comment and malformed lines are skipped
+    static QList<CurvePoint> loadCurve(const QString &filePath);
+
+    QList<double> bandFrequencies() const;
+
+    // Values ready for HeadsetControlAPI::setEqualizer(), empty if the curve or the
+    // equalizer can't be fitted. rmsError receives the remaining error in dB, once the
+    // best overall level is taken out.
+    QList<double> fit(const QList<CurvePoint> &target, double *rmsError = nullptr) const;
+
+private:
+    Equalizer equalizer;
+    QList<double> frequencies;
+    // Band width in octaves, shared by every band
+    double width = 1;
+
+    double bandResponse(int band, double frequency) const;
+    static double residual(const std::vector<double> &gram,
+                           const std::vector<double> &projection,
+                           const std::vector<double> &gains);
+};
+
+#endif // EQUALIZERFIT_H
@@ -0,0 +1,95 @@
+#include "faketransport.h"
+
+FakeTransport::FakeTransport(QObject *parent)
+    : HeadsetTransport(parent)
+{
+    name = "FakeTransport";
+    version = QVersionNumber(0, 0, 0);
+    devices.append(createTestDevice());
+}
+
+bool FakeTransport::isAvailable() const
+{
+    return true;
+}
+
+QFuture<QList<Device>> FakeTransport::enumerate()
+{
+    return QtFuture::makeReadyValueFuture(devices);
+}
+
+QFuture<QList<DeviceStatus>> FakeTransport::status()
+{
+    QList<DeviceStatus> result;
+    for (const Device &device : std::as_const(devices)) {
+        DeviceStatus status;
+        status.id_vendor = device.id_vendor;
+        status.id_product = device.id_product;
+        status.status = device.status;
+        status.has_battery = device.capabilities.contains("CAP_BATTERY_STATUS");
+        status.battery = device.battery;
+        status.has_chatmix = device.capabilities.contains("CAP_CHATMIX_STATUS");
+        status.chatmix = device.chatmix;
+        result.append(status);
+    }
+    return QtFuture::makeReadyValueFuture(result);
+}
+
+QFuture<QList<Action>> FakeTransport::apply(const QList<Command> &commands)
+{
+    QList<Action> actions;
+    for (const Command &command : commands) {
+        appliedCommands.append(command);
+
+        Action action;
+        action.capability = command.capability;
+        action.device = devices.isEmpty() ? QString() : devices.first().device;
+        action.success = !devices.isEmpty() && !failingCapabilities.contains(command.capability);
+        action.status = action.success ? "success" : "failure";
+        if (action.success) {
+            devices.first().applySetting(command.capability, command.value);
+        } else {
+            action.error_message = "Simulated failure";
+        }
+        actions.append(action);
+    }
+    return QtFuture::makeReadyValueFuture(actions);
+}
+
+Device FakeTransport::createTestDevice()
+{
+    Device device;
+    device.status = "success";
+    device.device = "HeadsetControl Test device";
+    device.vendor = "HeadsetControl";
+    device.product = "Test device";
+    device.id_vendor = "0xf00b";
+    device.id_product = "0xa00c";
+    device.capabilities = QSet<QString>{"CAP_SIDETONE",
+                                        "CAP_BATTERY_STATUS",
+                                        "CAP_NOTIFICATION_SOUND",
+                                        "CAP_LIGHTS",
+                                        "CAP_INACTIVE_TIME",
+                                        "CAP_CHATMIX_STATUS",
+                                        "CAP_VOICE_PROMPTS",
+                                        "CAP_ROTATE_TO_MUTE",
+                                        "CAP_EQUALIZER_PRESET",
+                                        "CAP_EQUALIZER",
+                                        "CAP_MICROPHONE_MUTE_LED_BRIGHTNESS",
+                                        "CAP_MICROPHONE_VOLUME",
+                                        "CAP_VOLUME_LIMITER",
+                                        "CAP_BT_WHEN_POWERED_ON",
+                                        "CAP_BT_CALL_VOLUME"};
+    device.battery = Battery("BATTERY_AVAILABLE", 42);
+    device.chatmix = 42;
+    device.equalizer = Equalizer(10, 0, 0.5, -10, 10);
+    device.equalizer_curve = QList<double>(device.equalizer.bands_number,
+                                           device.equalizer.band_baseline);
+    for (int i = 0; i < 4; ++i) {
+        EqualizerPreset preset;
+        preset.name = QString("Preset %1").arg(i + 1);
+        preset.values = QList<double>(device.equalizer.bands_number, i);
+        device.presets_list.append(preset);
+    }
+    return device;
+}
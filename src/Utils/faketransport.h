@@ -0,0 +1,30 @@
+#ifndef FAKETRANSPORT_H
+#define FAKETRANSPORT_H
+
+#include "headsettransport.h"
+
+// In-memory backend that behaves like a fully featured headset. It needs no
+// hardware, applies every command to its own device state and records them,
+// so the layers above it can be exercised deterministically.
+class FakeTransport : public HeadsetTransport
+{
+    Q_OBJECT
+
+public:
+    explicit FakeTransport(QObject *parent = nullptr);
+
+    bool isAvailable() const override;
+
+    QFuture<QList<Device>> enumerate() override;
+    QFuture<QList<DeviceStatus>> status() override;
+    QFuture<QList<Action>> apply(const QList<Command> &commands) override;
+
+    QList<Device> devices;
+    QList<Command> appliedCommands;
+    // Capabilities listed here report an error instead of succeeding
+    QSet<QString> failingCapabilities;
+
+    static Device createTestDevice();
+};
+
+#endif // FAKETRANSPORT_H
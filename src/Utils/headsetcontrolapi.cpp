@@ -1,245 +1,433 @@
 #include "headsetcontrolapi.h"
 
-#include <QJsonArray>
-#include <QJsonDocument>
-#include <QProcess>
+#include "deviceregistry.h"
+#include "faketransport.h"
+#include "subprocesstransport.h"
+
+#ifdef HEADSETCONTROL_HIDAPI
+#include "attachmentcachetransport.h"
+#endif
+
+#include <QDebug>
 
 HeadsetControlAPI::HeadsetControlAPI(QString headsetcontrolFilePath)
+    : HeadsetControlAPI(createTransport(headsetcontrolFilePath))
+{}
+
+HeadsetControlAPI::HeadsetControlAPI(HeadsetTransport *transport)
+    : transport(transport)
+    , batchTimer(this)
+{
+    transport->setParent(this);
+    updateInfo();
+    connect(transport,
+            &HeadsetTransport::statusUpdated,
+            this,
+            [this](QList<DeviceStatus> statuses) {
+                DeviceRegistry::assignUnitIds(statuses, attachedUnits);
+                publishStatus(statuses);
+            });
+
+    batchTimer.setSingleShot(true);
+    commandClock.start();
+    connect(&batchTimer, &QTimer::timeout, this, &HeadsetControlAPI::flushBatch);
+}
+
+HeadsetTransport *HeadsetControlAPI::createTransport(const QString &headsetcontrolFilePath)
 {
-    this->headsetcontrolFilePath = headsetcontrolFilePath;
-    sendCommand(QStringList());
+    // Lets the whole GUI run without a headset attached
+    if (qEnvironmentVariableIsSet("HEADSETCONTROL_GUI_FAKE_TRANSPORT")) {
+        return new FakeTransport();
+    }
+#ifdef HEADSETCONTROL_HIDAPI
+    return new AttachmentCacheTransport(new SubprocessTransport(headsetcontrolFilePath));
+#else
+    return new SubprocessTransport(headsetcontrolFilePath);
+#endif
 }
 
-QString HeadsetControlAPI::getName()
+QString HeadsetControlAPI::getName() const
 {
+    QMutexLocker locker(&infoMutex);
     return name;
 }
 
-QVersionNumber HeadsetControlAPI::getVersion()
+QVersionNumber HeadsetControlAPI::getVersion() const
 {
+    QMutexLocker locker(&infoMutex);
     return version;
 }
 
-QVersionNumber HeadsetControlAPI::getApiVersion()
+QVersionNumber HeadsetControlAPI::getApiVersion() const
 {
+    QMutexLocker locker(&infoMutex);
     return api_version;
 }
 
-QVersionNumber HeadsetControlAPI::getHidApiVersion()
+QVersionNumber HeadsetControlAPI::getHidApiVersion() const
 {
+    QMutexLocker locker(&infoMutex);
     return hidapi_version;
 }
 
-QList<Device *> HeadsetControlAPI::getConnectedDevices()
+void HeadsetControlAPI::updateInfo()
 {
-    QStringList args = QStringList() << QString("--output") << QString("JSON");
-    QString output = sendCommand(args);
-    QJsonDocument jsonDoc = QJsonDocument::fromJson(output.toUtf8());
-    QJsonObject jsonInfo = jsonDoc.object();
+    QMutexLocker locker(&infoMutex);
+    name = transport->getName();
+    version = transport->getVersion();
+    api_version = transport->getApiVersion();
+    hidapi_version = transport->getHidApiVersion();
+}
 
-    name = jsonInfo["name"].toString();
-    version = QVersionNumber::fromString(jsonInfo["version"].toString());
-    api_version = QVersionNumber::fromString(jsonInfo["api_version"].toString());
-    hidapi_version = QVersionNumber::fromString(jsonInfo["hidapi_version"].toString());
+bool HeadsetControlAPI::isAvailable() const
+{
+    // Only looks at immutable state (the binary path), safe from any thread
+    return transport->isAvailable();
+}
 
-    int device_number = jsonInfo["device_count"].toInt();
-    qDebug() << "Found" << device_number << "devices:";
+QFuture<QList<Device>> HeadsetControlAPI::getConnectedDevices()
+{
+    return requestOnApiThread<QList<Device>>([this]() {
+        return transport->enumerate().then([this](QList<Device> devices) {
+            updateInfo();
+            // Only re-read when the devices may have changed, status polls reuse it
+            attachedUnits = DeviceRegistry::physicalUnits();
+            DeviceRegistry::assignUnitIds(devices, attachedUnits);
+            return devices;
+        });
+    });
+}
 
-    QList<Device *> devices;
-    QJsonArray jsonDevices = jsonInfo["devices"].toArray();
-    if (!jsonDoc.isNull()) {
-        for (int i = 0; i < device_number; ++i) {
-            Device *device = new Device(jsonDevices[i].toObject(), output);
-            devices.append(device);
-            qDebug() << "\t" << device->device;
-        }
-    }
+QFuture<QList<DeviceStatus>> HeadsetControlAPI::getStatus()
+{
+    return requestOnApiThread<QList<DeviceStatus>>([this]() {
+        return transport->status().then([this](QList<DeviceStatus> statuses) {
+            DeviceRegistry::assignUnitIds(statuses, attachedUnits);
+            publishStatus(statuses);
+            return statuses;
+        });
+    });
+}
 
-    return devices;
+std::shared_ptr<const DeviceState> HeadsetControlAPI::getState() const
+{
+    return state.load();
 }
 
-// HC rleated functions
-QString HeadsetControlAPI::sendCommand(const QStringList &args_list)
+void HeadsetControlAPI::publishStatus(const QList<DeviceStatus> &statuses)
 {
-    QProcess *proc = new QProcess();
-    QStringList args = QStringList() << QString("--output") << QString("JSON");
-    //args << QString("--test-device"); //Uncomment this to enable all "modules"
-    args << args_list;
+    // Only the API thread publishes, so reading the previous sequence is race free
+    DeviceState next;
+    next.sequence = state.load()->sequence + 1;
+    next.statuses = statuses;
+    state.publish(std::move(next));
 
-    proc->start(headsetcontrolFilePath, args);
-    proc->waitForFinished();
-    QString output = proc->readAllStandardOutput();
-    qDebug() << "Command: \t" << headsetcontrolFilePath;
-    qDebug() << "\tArgs: \theadsetcontrol " << args;
-    // qDebug() << output;
-    qDebug() << "Error: \t" << proc->error();
+    emit statusUpdated(statuses);
+}
+
+void HeadsetControlAPI::startFollowing(int secondsInterval)
+{
+    following = true;
+    if (forwardToApiThread([=]() { transport->startFollowing(secondsInterval); })) {
+        return;
+    }
+    transport->startFollowing(secondsInterval);
+}
 
-    delete (proc);
+void HeadsetControlAPI::stopFollowing()
+{
+    following = false;
+    if (forwardToApiThread([this]() { transport->stopFollowing(); })) {
+        return;
+    }
+    transport->stopFollowing();
+}
 
-    return output;
+bool HeadsetControlAPI::isFollowing() const
+{
+    return following;
 }
 
-Action HeadsetControlAPI::sendAction(const QStringList &args_list)
+// Batching Section
+void HeadsetControlAPI::beginBatch()
 {
-    QString output = sendCommand(args_list);
-    QJsonDocument jsonDoc = QJsonDocument::fromJson(output.toUtf8());
-    QJsonObject jsonInfo = jsonDoc.object();
-    QJsonArray actions = jsonInfo["actions"].toArray();
-    Action action;
-    if (!actions.isEmpty()) {
-        QJsonObject jaction = actions[0].toObject();
+    if (forwardToApiThread([this]() { beginBatch(); })) {
+        return;
+    }
+    batchDepth++;
+}
 
-        action.device = jaction["device"].toString();
-        action.capability = jaction["capability"].toString();
-        action.status = jaction["status"].toString();
-        action.error_message = jaction["error_message"].toString();
+void HeadsetControlAPI::commitBatch()
+{
+    if (forwardToApiThread([this]() { commitBatch(); })) {
+        return;
+    }
+    if (batchDepth > 0 && --batchDepth == 0) {
+        flushBatch();
+    }
+}
 
-        action.success = action.status == "success";
+void HeadsetControlAPI::setCommandInterval(int msec)
+{
+    if (forwardToApiThread([=]() { setCommandInterval(msec); })) {
+        return;
+    }
+    msecCommandInterval = qMax(0, msec);
+}
 
-        qDebug() << "Device:\t" << action.device;
-        qDebug() << "Capability:" << action.capability;
-        qDebug() << "Status:\t" << action.status;
-        if (!action.success) {
-            qDebug() << "Error:\t" << action.error_message;
+void HeadsetControlAPI::queueCommand(const Command &command)
+{
+    // Every setter ends up here, so this single hop keeps their order
+    if (forwardToApiThread([=]() { queueCommand(command); })) {
+        return;
+    }
+    // A newer value for the same capability replaces the pending one before it is ever spawned
+    for (Command &pending : pendingCommands) {
+        if (pending.capability == command.capability) {
+            pending = command;
+            return;
         }
     }
+    pendingCommands.append(command);
 
-    return action;
+    if (batchDepth == 0 && !batchTimer.isActive()) {
+        batchTimer.start(MSEC_BATCH_WINDOW);
+    }
 }
 
-void HeadsetControlAPI::setSidetone(Device *device, int level)
+static const Action *findAction(const QList<Action> &actions,
+                                const QString &capability,
+                                int index,
+                                int commandCount)
 {
-    QStringList args = QStringList() << QString("--sidetone") << QString::number(level);
-    Action a = sendAction(args);
-    if (a.success) {
-        device->sidetone = level;
-        emit actionSuccesful();
+    // Entries carry either the enum name (CAP_SIDETONE) or the short name (sidetone)
+    for (const Action &action : actions) {
+        if (action.capability == capability
+            || "CAP_" + action.capability.toUpper().replace(' ', '_') == capability) {
+            return &action;
+        }
+    }
+    // Otherwise rely on headsetcontrol reporting one entry per flag, in order
+    if (actions.length() == commandCount) {
+        return &actions.at(index);
     }
+    return nullptr;
 }
 
-void HeadsetControlAPI::setLights(Device *device, bool enabled)
+void HeadsetControlAPI::flushBatch()
 {
-    QStringList args = QStringList() << QString("--light") << QString::number(enabled);
-    Action a = sendAction(args);
-    if (a.success) {
-        device->lights = enabled;
-        emit actionSuccesful();
+    batchTimer.stop();
+
+    // Capabilities that are still in flight, or were sent too recently, stay
+    // queued so each one has at most a single headsetcontrol call running
+    QList<Command> commands;
+    qint64 now = commandClock.elapsed();
+    qint64 msecNextFlush = -1;
+    for (auto it = pendingCommands.begin(); it != pendingCommands.end();) {
+        if (inFlightCapabilities.contains(it->capability)) {
+            ++it;
+            continue;
+        }
+        qint64 msecWait = lastSent.contains(it->capability)
+                              ? lastSent.value(it->capability) + msecCommandInterval - now
+                              : 0;
+        if (msecWait > 0) {
+            msecNextFlush = msecNextFlush < 0 ? msecWait : qMin(msecNextFlush, msecWait);
+            ++it;
+            continue;
+        }
+
+        inFlightCapabilities.insert(it->capability);
+        lastSent.insert(it->capability, now);
+        commands.append(*it);
+        it = pendingCommands.erase(it);
+    }
+    if (msecNextFlush >= 0) {
+        batchTimer.start(msecNextFlush);
+    }
+    if (commands.isEmpty()) {
+        return;
     }
+
+    transport->apply(commands)
+        .then(this,
+              [=](const QList<Action> &actions) {
+                  bool anySuccess = false;
+                  for (int i = 0; i < commands.length(); ++i) {
+                      const Command &command = commands.at(i);
+                      const Action *action = findAction(actions,
+                                                        command.capability,
+                                                        i,
+                                                        commands.length());
+                      if (action != nullptr && action->success) {
+                          emit settingApplied(command.capability, command.value);
+                          anySuccess = true;
+                      }
+                  }
+                  if (anySuccess) {
+                      emit actionSuccesful();
+                  }
+                  releaseCapabilities(commands);
+              })
+        .onFailed(this,
+                  [=]() {
+                      qDebug() << "ERROR: Sending" << commands.length() << "commands failed";
+                      releaseCapabilities(commands);
+                  })
+        .onCanceled(this, [=]() { releaseCapabilities(commands); });
 }
 
-void HeadsetControlAPI::setVoicePrompts(Device *device, bool enabled)
+void HeadsetControlAPI::releaseCapabilities(const QList<Command> &commands)
 {
-    QStringList args = QStringList() << QString("--voice-prompt") << QString::number(enabled);
-    Action a = sendAction(args);
-    if (a.success) {
-        device->voice_prompts = enabled;
-        emit actionSuccesful();
+    // Whatever became of the batch, its capabilities must not stay blocked
+    for (const Command &command : commands) {
+        inFlightCapabilities.remove(command.capability);
+    }
+    // Send whatever was superseded while this batch was running
+    if (batchDepth == 0 && !pendingCommands.isEmpty()) {
+        flushBatch();
     }
 }
 
-void HeadsetControlAPI::setInactiveTime(Device *device, int time)
+void HeadsetControlAPI::restoreDeviceSettings(const Device &device)
 {
-    QStringList args = QStringList() << QString("--inactive-time") << QString::number(time);
-    Action a = sendAction(args);
-    if (a.success) {
-        device->inactive_time = time;
-        emit actionSuccesful();
+    // Works on its own copy of the device, which the caller is free to change meanwhile
+    if (forwardToApiThread([=]() { restoreDeviceSettings(device); })) {
+        return;
+    }
+    const QSet<QString> &capabilities = device.capabilities;
+
+    beginBatch();
+    if (capabilities.contains("CAP_LIGHTS") && device.lights >= 0) {
+        setLights(device.lights);
+    }
+    if (capabilities.contains("CAP_SIDETONE") && device.sidetone >= 0) {
+        setSidetone(device.sidetone);
     }
+    if (capabilities.contains("CAP_VOICE_PROMPTS") && device.voice_prompts >= 0) {
+        setVoicePrompts(device.voice_prompts);
+    }
+    if (capabilities.contains("CAP_INACTIVE_TIME") && device.inactive_time >= 0) {
+        setInactiveTime(device.inactive_time);
+    }
+    if (capabilities.contains("CAP_EQUALIZER_PRESET") && device.equalizer_preset >= 0) {
+        setEqualizerPreset(device.equalizer_preset);
+    } else if (capabilities.contains("CAP_EQUALIZER") && device.equalizer.bands_number > 0
+               && device.equalizer_curve.length() == device.equalizer.bands_number) {
+        setEqualizer(device.equalizer_curve);
+    }
+    if (capabilities.contains("CAP_VOLUME_LIMITER") && device.volume_limiter >= 0) {
+        setVolumeLimiter(device.volume_limiter);
+    }
+    if (capabilities.contains("CAP_ROTATE_TO_MUTE") && device.rotate_to_mute >= 0) {
+        setRotateToMute(device.rotate_to_mute);
+    }
+    if (capabilities.contains("CAP_MICROPHONE_MUTE_LED_BRIGHTNESS")
+        && device.mic_mute_led_brightness >= 0) {
+        setMuteLedBrightness(device.mic_mute_led_brightness);
+    }
+    if (capabilities.contains("CAP_MICROPHONE_VOLUME") && device.mic_volume >= 0) {
+        setMicrophoneVolume(device.mic_volume);
+    }
+    if (capabilities.contains("CAP_BT_WHEN_POWERED_ON") && device.bt_when_powered_on >= 0) {
+        setBluetoothWhenPoweredOn(device.bt_when_powered_on);
+    }
+    if (capabilities.contains("CAP_BT_CALL_VOLUME") && device.bt_call_volume >= 0) {
+        setBluetoothCallVolume(device.bt_call_volume);
+    }
+    commitBatch();
 }
 
-void HeadsetControlAPI::playNotificationSound(Device *device, int id)
+void HeadsetControlAPI::setSidetone(int level)
 {
-    QStringList args = QStringList() << QString("--notificate") << QString::number(id);
-    Action a = sendAction(args);
-    if (a.success) {
-        device->notification_sound = id;
-        emit actionSuccesful();
-    }
+    queueCommand(Command("CAP_SIDETONE", "--sidetone", QString::number(level), level));
 }
 
-void HeadsetControlAPI::setVolumeLimiter(Device *device, bool enabled)
+void HeadsetControlAPI::setLights(bool enabled)
 {
-    QStringList args = QStringList() << QString("--volume-limiter") << QString::number(enabled);
-    Action a = sendAction(args);
-    if (a.success) {
-        device->volume_limiter = enabled;
-        emit actionSuccesful();
-    }
+    queueCommand(Command("CAP_LIGHTS", "--light", QString::number(enabled), enabled));
+}
+
+void HeadsetControlAPI::setVoicePrompts(bool enabled)
+{
+    queueCommand(Command("CAP_VOICE_PROMPTS", "--voice-prompt", QString::number(enabled), enabled));
+}
+
+void HeadsetControlAPI::setInactiveTime(int time)
+{
+    queueCommand(Command("CAP_INACTIVE_TIME", "--inactive-time", QString::number(time), time));
+}
+
+void HeadsetControlAPI::playNotificationSound(int id)
+{
+    queueCommand(Command("CAP_NOTIFICATION_SOUND", "--notificate", QString::number(id), id));
 }
 
-void HeadsetControlAPI::setEqualizer(Device *device, QList<double> equalizerValues)
+void HeadsetControlAPI::setVolumeLimiter(bool enabled)
+{
+    queueCommand(Command("CAP_VOLUME_LIMITER",
+                         "--volume-limiter",
+                         QString::number(enabled),
+                         enabled));
+}
+
+void HeadsetControlAPI::setEqualizer(QList<double> equalizerValues)
 {
     QString equalizer = "";
     for (double value : equalizerValues) {
         equalizer += QString::number(value) + ",";
     }
     equalizer.removeLast();
-    QStringList args = QStringList() << QString("--equalizer") << equalizer;
-    Action a = sendAction(args);
-    if (a.success) {
-        device->equalizer_curve = equalizerValues;
-        device->equalizer_preset = -1;
-        emit actionSuccesful();
-    }
+    queueCommand(Command("CAP_EQUALIZER",
+                         "--equalizer",
+                         equalizer,
+                         QVariant::fromValue(equalizerValues)));
 }
 
-void HeadsetControlAPI::setEqualizerPreset(Device *device, int number)
+void HeadsetControlAPI::setEqualizerPreset(int number)
 {
-    QStringList args = QStringList() << QString("--equalizer-preset") << QString::number(number);
-    Action a = sendAction(args);
-    if (a.success) {
-        device->equalizer_preset = number;
-        emit actionSuccesful();
-    }
+    queueCommand(Command("CAP_EQUALIZER_PRESET",
+                         "--equalizer-preset",
+                         QString::number(number),
+                         number));
 }
 
-void HeadsetControlAPI::setRotateToMute(Device *device, bool enabled)
+void HeadsetControlAPI::setRotateToMute(bool enabled)
 {
-    QStringList args = QStringList() << QString("--rotate-to-mute") << QString::number(enabled);
-    Action a = sendAction(args);
-    if (a.success) {
-        device->rotate_to_mute = enabled;
-        emit actionSuccesful();
-    }
+    queueCommand(Command("CAP_ROTATE_TO_MUTE",
+                         "--rotate-to-mute",
+                         QString::number(enabled),
+                         enabled));
 }
 
-void HeadsetControlAPI::setMuteLedBrightness(Device *device, int brightness)
+void HeadsetControlAPI::setMuteLedBrightness(int brightness)
 {
-    QStringList args = QStringList() << QString("--microphone-mute-led-brightness")
-                                     << QString::number(brightness);
-    Action a = sendAction(args);
-    if (a.success) {
-        device->mic_mute_led_brightness = brightness;
-        emit actionSuccesful();
-    }
+    queueCommand(Command("CAP_MICROPHONE_MUTE_LED_BRIGHTNESS",
+                         "--microphone-mute-led-brightness",
+                         QString::number(brightness),
+                         brightness));
 }
 
-void HeadsetControlAPI::setMicrophoneVolume(Device *device, int volume)
+void HeadsetControlAPI::setMicrophoneVolume(int volume)
 {
-    QStringList args = QStringList() << QString("--microphone-volume") << QString::number(volume);
-    Action a = sendAction(args);
-    if (a.success) {
-        device->mic_volume = volume;
-        emit actionSuccesful();
-    }
+    queueCommand(Command("CAP_MICROPHONE_VOLUME",
+                         "--microphone-volume",
+                         QString::number(volume),
+                         volume));
 }
 
-void HeadsetControlAPI::setBluetoothWhenPoweredOn(Device *device, bool enabled)
+void HeadsetControlAPI::setBluetoothWhenPoweredOn(bool enabled)
 {
-    QStringList args = QStringList() << QString("--bt-when-powered-on") << QString::number(enabled);
-    Action a = sendAction(args);
-    if (a.success) {
-        device->bt_when_powered_on = enabled;
-        emit actionSuccesful();
-    }
+    queueCommand(Command("CAP_BT_WHEN_POWERED_ON",
+                         "--bt-when-powered-on",
+                         QString::number(enabled),
+                         enabled));
 }
 
-void HeadsetControlAPI::setBluetoothCallVolume(Device *device, int option)
+void HeadsetControlAPI::setBluetoothCallVolume(int option)
 {
-    QStringList args = QStringList() << QString("--bt-call-volume") << QString::number(option);
-    Action a = sendAction(args);
-    if (a.success) {
-        device->bt_call_volume = option;
-        emit actionSuccesful();
-    }
+    queueCommand(Command("CAP_BT_CALL_VOLUME",
+                         "--bt-call-volume",
+                         QString::number(option),
+                         option));
 }
@@ -1,67 +1,157 @@
 #ifndef HEADSETCONTROLAPI_H
 #define HEADSETCONTROLAPI_H
 
+#include "command.h"
 #include "device.h"
+#include "headsettransport.h"
+#include "snapshotpublisher.h"
 
-#include <QFile>
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QMutex>
 #include <QObject>
+#include <QPromise>
+#include <QStringList>
+#include <QThread>
+#include <QTimer>
 #include <QVersionNumber>
 
-class Action
-{
-public:
-    bool success;
-    QString capability;
-    QString device;
-    QString status;
-    QString error_message;
-};
+#include <atomic>
+#include <memory>
 
+// Meant to live on its own thread, away from the GUI. Every public method can
+// be called from any thread: the call is queued to the API thread, and results
+// come back as futures or queued signals carrying plain values, so Device
+// objects are never shared between the two.
 class HeadsetControlAPI : public QObject
 {
     Q_OBJECT
 
 public:
     HeadsetControlAPI(QString headsetcontrolFilePath);
+    // Takes ownership of the transport
+    HeadsetControlAPI(HeadsetTransport *transport);
+
+    // Copies of what the transport reported on its last enumeration
+    QString getName() const;
+    QVersionNumber getVersion() const;
+    QVersionNumber getApiVersion() const;
+    QVersionNumber getHidApiVersion() const;
 
-    QString getName();
-    QVersionNumber getVersion();
-    QVersionNumber getApiVersion();
-    QVersionNumber getHidApiVersion();
+    bool isAvailable() const;
 
-    QList<Device *> getConnectedDevices();
+    // Only needed when the set of devices may have changed;
+    // getStatus() covers the periodic refresh
+    QFuture<QList<Device>> getConnectedDevices();
+    QFuture<QList<DeviceStatus>> getStatus();
+    // Latest statuses, from polls and the follow stream alike; safe from any thread
+    std::shared_ptr<const DeviceState> getState() const;
+
+    // Emits statusUpdated() for each report the transport pushes,
+    // instead of polling once per interval
+    void startFollowing(int secondsInterval);
+    void stopFollowing();
+    bool isFollowing() const;
+
+    // Setters called between beginBatch() and commitBatch() are sent as a
+    // single headsetcontrol invocation; outside of a transaction they are
+    // coalesced over a short window instead
+    void beginBatch();
+    void commitBatch();
+    void restoreDeviceSettings(const Device &device);
+
+    // Minimum time between two commands for the same capability
+    void setCommandInterval(int msec);
 
 private:
-    QString headsetcontrolFilePath;
-    QFile headsetcontrol;
+    HeadsetTransport *transport;
 
+    mutable QMutex infoMutex;
     QString name;
     QVersionNumber version;
     QVersionNumber api_version;
     QVersionNumber hidapi_version;
 
-    QString sendCommand(const QStringList &args_list);
-    Action sendAction(const QStringList &args_list);
+    SnapshotPublisher<DeviceState> state;
+    // Names of the attached units as of the last enumeration, see DeviceRegistry
+    QHash<quint32, QStringList> attachedUnits;
+
+    // Set by the caller's thread, so it already reads true right after startFollowing()
+    std::atomic<bool> following{false};
+
+    static constexpr int MSEC_BATCH_WINDOW = 50;
+    QTimer batchTimer;
+    int batchDepth = 0;
+    QList<Command> pendingCommands;
+
+    int msecCommandInterval = 100;
+    QElapsedTimer commandClock;
+    QHash<QString, qint64> lastSent;
+    QSet<QString> inFlightCapabilities;
+
+    static HeadsetTransport *createTransport(const QString &headsetcontrolFilePath);
+
+    void updateInfo();
+    void publishStatus(const QList<DeviceStatus> &statuses);
+    void queueCommand(const Command &command);
+    void flushBatch();
+    void releaseCapabilities(const QList<Command> &commands);
+
+    // Queues call to the API thread when invoked from another one; returns whether it did
+    template<typename Function>
+    bool forwardToApiThread(Function call)
+    {
+        if (QThread::currentThread() == thread()) {
+            return false;
+        }
+        QMetaObject::invokeMethod(this, call, Qt::QueuedConnection);
+        return true;
+    }
+
+    // Starts request on the API thread and hands its result back through a future
+    // usable from the calling thread
+    template<typename T, typename Function>
+    QFuture<T> requestOnApiThread(Function request)
+    {
+        if (QThread::currentThread() == thread()) {
+            return request();
+        }
+        // Dropped unfinished (request cancelled, thread stopped) it cancels the future
+        auto promise = std::make_shared<QPromise<T>>();
+        promise->start();
+        QFuture<T> future = promise->future();
+        forwardToApiThread([promise, request]() {
+            request().then([promise](const T &result) {
+                promise->addResult(result);
+                promise->finish();
+            });
+        });
+        return future;
+    }
 
 public slots:
-    void setSidetone(Device *device, int level);
-    void setLights(Device *device, bool enabled);
-    void setVoicePrompts(Device *device, bool enabled);
-    void setInactiveTime(Device *device, int time);
-    void playNotificationSound(Device *device, int id);
-    void setVolumeLimiter(Device *device, bool enabled);
-    void setEqualizer(Device *device, QList<double> equalizerValues);
-    void setEqualizerPreset(Device *device, int number);
-
-    void setRotateToMute(Device *device, bool enabled);
-    void setMuteLedBrightness(Device *device, int brightness);
-    void setMicrophoneVolume(Device *device, int volume);
-
-    void setBluetoothWhenPoweredOn(Device *device, bool enabled);
-    void setBluetoothCallVolume(Device *device, int option);
+    void setSidetone(int level);
+    void setLights(bool enabled);
+    void setVoicePrompts(bool enabled);
+    void setInactiveTime(int time);
+    void playNotificationSound(int id);
+    void setVolumeLimiter(bool enabled);
+    void setEqualizer(QList<double> equalizerValues);
+    void setEqualizerPreset(int number);
+
+    void setRotateToMute(bool enabled);
+    void setMuteLedBrightness(int brightness);
+    void setMicrophoneVolume(int volume);
+
+    void setBluetoothWhenPoweredOn(bool enabled);
+    void setBluetoothCallVolume(int option);
 
 signals:
+    // One per command headsetcontrol confirmed, before the batch's actionSuccesful()
+    void settingApplied(const QString &capability, const QVariant &value);
     void actionSuccesful();
+    // Emitted right after the statuses were published to getState()
+    void statusUpdated(const QList<DeviceStatus> &statuses);
 };
 
 #endif // HEADSETCONTROLAPI_H
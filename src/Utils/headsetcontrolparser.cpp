@@ -0,0 +1,596 @@
+#include "headsetcontrolparser.h"
+
+#include <cmath>
+#include <cstring>
+
+static bool equals(QByteArrayView key, const char *literal)
+{
+    const size_t length = strlen(literal);
+    return size_t(key.size()) == length && memcmp(key.data(), literal, length) == 0;
+}
+
+static bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+// True when value already holds exactly these bytes, all of them plain ASCII
+static bool holds(const QString &value, const char *data, qsizetype size)
+{
+    if (value.size() != size) {
+        return false;
+    }
+    const QChar *chars = value.constData();
+    for (qsizetype i = 0; i < size; ++i) {
+        const uchar c = uchar(data[i]);
+        if (c >= 0x80 || chars[i].unicode() != c) {
+            return false;
+        }
+    }
+    return true;
+}
+
+HeadsetControlParser::HeadsetControlParser(DeviceMetadataCache *metadataCache)
+    : metadataCache(metadataCache)
+{}
+
+bool HeadsetControlParser::parse(const QByteArray &data, HeadsetControlOutput &output)
+{
+    pos = data.constData();
+    end = pos + data.size();
+
+    skipWhitespace();
+    if (pos == end || !parseRoot(output)) {
+        output.devices.clear();
+        return false;
+    }
+    return true;
+}
+
+bool HeadsetControlParser::parseStatus(const QByteArray &data, QList<DeviceStatus> &statuses)
+{
+    pos = data.constData();
+    end = pos + data.size();
+
+    skipWhitespace();
+    bool ok = pos != end && parseObject([&](QByteArrayView key) {
+        if (!equals(key, "devices")) {
+            return skipValue();
+        }
+        return parseArray([&]() {
+            DeviceStatus status;
+            if (!parseDeviceStatus(status)) {
+                return false;
+            }
+            statuses.append(status);
+            return true;
+        });
+    });
+    if (!ok) {
+        statuses.clear();
+    }
+    return ok;
+}
+
+bool HeadsetControlParser::parseRoot(HeadsetControlOutput &output)
+{
+    qsizetype deviceCount = 0;
+    output.actions.clear();
+
+    bool ok = parseObject([&](QByteArrayView key) {
+        if (equals(key, "name")) {
+            return readString(output.name);
+        }
+        if (equals(key, "version")) {
+            return readString(output.version);
+        }
+        if (equals(key, "api_version")) {
+            return readString(output.api_version);
+        }
+        if (equals(key, "hidapi_version")) {
+            return readString(output.hidapi_version);
+        }
+        if (equals(key, "devices")) {
+            return parseArray([&]() {
+                // Devices left from the previous parse are overwritten in place
+                const bool reused = deviceCount < output.devices.size();
+                if (!reused) {
+                    output.devices.append(Device());
+                }
+                return parseDevice(output.devices[deviceCount++], reused);
+            });
+        }
+        if (equals(key, "actions")) {
+            return parseArray([&]() {
+                Action action;
+                if (!parseAction(action)) {
+                    return false;
+                }
+                output.actions.append(action);
+                return true;
+            });
+        }
+        return skipValue();
+    });
+    output.devices.resize(deviceCount);
+    return ok;
+}
+
+bool HeadsetControlParser::parseDevice(Device &device, bool reused)
+{
+    // Everything is read straight into device. When it held the same headset on the
+    // previous parse, readString() finds the same text there and keeps it.
+    const char *start = pos;
+    bool hasStatus = false;
+    bool hasBattery = false;
+    int chatmix = 65;
+
+    const Device *cached = nullptr;
+    bool lookedUp = false;
+
+    bool ok = parseObject([&](QByteArrayView key) {
+        if (equals(key, "status")) {
+            hasStatus = true;
+            return readString(device.status);
+        }
+        if (equals(key, "battery")) {
+            hasBattery = true;
+            return parseBattery(device.battery);
+        }
+        if (equals(key, "chatmix")) {
+            return readInt(chatmix);
+        }
+        if (cached != nullptr) {
+            return skipValue();
+        }
+
+        bool result;
+        if (equals(key, "device")) {
+            result = readString(device.device);
+        } else if (equals(key, "vendor")) {
+            result = readString(device.vendor);
+        } else if (equals(key, "product")) {
+            result = readString(device.product);
+        } else if (equals(key, "id_vendor")) {
+            result = readString(device.id_vendor);
+        } else if (equals(key, "id_product")) {
+            result = readString(device.id_product);
+        } else if (equals(key, "capabilities")) {
+            result = parseStringArray(device.capabilities);
+        } else if (equals(key, "equalizer")) {
+            result = parseEqualizer(device.equalizer);
+        } else if (equals(key, "equalizer_presets")) {
+            result = parseEqualizerPresets(device.presets_list);
+        } else {
+            return skipValue();
+        }
+
+        // The ids come first in headsetcontrol's output, so everything heavy after them is skipped
+        if (!lookedUp && metadataCache != nullptr && !device.id_vendor.isEmpty()
+            && !device.id_product.isEmpty()) {
+            lookedUp = true;
+            cached = metadataCache->find(DeviceKey::packId(device.id_vendor, device.id_product));
+        }
+        return result;
+    });
+    if (!ok) {
+        return false;
+    }
+
+    if (cached == nullptr && reused) {
+        // Static fields were read over whatever device this was before; start again from a
+        // clean one so that nothing of it is left. With a metadata cache this only happens
+        // on the first sight of a model.
+        device = Device();
+        pos = start;
+        return parseDevice(device, false);
+    }
+
+    QString status = hasStatus ? device.status : QString();
+    Battery battery = device.battery;
+
+    if (cached != nullptr) {
+        device = *cached;
+    } else {
+        if (!device.capabilities.contains("CAP_EQUALIZER_PRESET")) {
+            device.presets_list.clear();
+        }
+        if (!device.capabilities.contains("CAP_EQUALIZER")) {
+            device.equalizer = Equalizer();
+        }
+        if (device.equalizer.bands_number > 0) {
+            device.equalizer_curve = QList<double>(device.equalizer.bands_number,
+                                                   device.equalizer.band_baseline);
+        }
+        device.status.clear();
+        device.battery = Battery();
+        if (metadataCache != nullptr) {
+            metadataCache->insert(DeviceKey::packId(device.id_vendor, device.id_product), device);
+        }
+    }
+
+    device.status = status;
+    if (device.capabilities.contains("CAP_BATTERY_STATUS")) {
+        device.battery = hasBattery ? battery : Battery();
+    }
+    if (device.capabilities.contains("CAP_CHATMIX_STATUS")) {
+        device.chatmix = chatmix;
+    }
+    return true;
+}
+
+bool HeadsetControlParser::parseDeviceStatus(DeviceStatus &status)
+{
+    // headsetcontrol only reports battery and chatmix for devices that have them
+    return parseObject([&](QByteArrayView key) {
+        if (equals(key, "id_vendor")) {
+            return readString(status.id_vendor);
+        }
+        if (equals(key, "id_product")) {
+            return readString(status.id_product);
+        }
+        if (equals(key, "status")) {
+            return readString(status.status);
+        }
+        if (equals(key, "battery")) {
+            status.has_battery = true;
+            return parseBattery(status.battery);
+        }
+        if (equals(key, "chatmix")) {
+            status.has_chatmix = true;
+            return readInt(status.chatmix);
+        }
+        return skipValue();
+    });
+}
+
+bool HeadsetControlParser::parseAction(Action &action)
+{
+    bool ok = parseObject([&](QByteArrayView key) {
+        if (equals(key, "device")) {
+            return readString(action.device);
+        }
+        if (equals(key, "capability")) {
+            return readString(action.capability);
+        }
+        if (equals(key, "status")) {
+            return readString(action.status);
+        }
+        if (equals(key, "error_message")) {
+            return readString(action.error_message);
+        }
+        return skipValue();
+    });
+    action.success = action.status == "success";
+    return ok;
+}
+
+bool HeadsetControlParser::parseBattery(Battery &battery)
+{
+    return parseObject([&](QByteArrayView key) {
+        if (equals(key, "status")) {
+            return readString(battery.status);
+        }
+        if (equals(key, "level")) {
+            return readInt(battery.level);
+        }
+        return skipValue();
+    });
+}
+
+bool HeadsetControlParser::parseEqualizer(Equalizer &equalizer)
+{
+    return parseObject([&](QByteArrayView key) {
+        if (equals(key, "bands")) {
+            return readInt(equalizer.bands_number);
+        }
+        if (equals(key, "baseline")) {
+            return readInt(equalizer.band_baseline);
+        }
+        if (equals(key, "step")) {
+            return readNumber(equalizer.band_step);
+        }
+        if (equals(key, "min")) {
+            return readInt(equalizer.band_min);
+        }
+        if (equals(key, "max")) {
+            return readInt(equalizer.band_max);
+        }
+        return skipValue();
+    });
+}
+
+bool HeadsetControlParser::parseEqualizerPresets(QList<EqualizerPreset> &presets)
+{
+    return parseObject([&](QByteArrayView key) {
+        EqualizerPreset preset;
+        preset.name = QString::fromUtf8(key);
+        if (!parseNumberArray(preset.values)) {
+            return false;
+        }
+        presets.append(preset);
+        return true;
+    });
+}
+
+bool HeadsetControlParser::parseStringArray(QSet<QString> &values)
+{
+    return parseArray([&]() {
+        QString value;
+        if (!readString(value)) {
+            return false;
+        }
+        values.insert(value);
+        return true;
+    });
+}
+
+bool HeadsetControlParser::parseNumberArray(QList<double> &values)
+{
+    return parseArray([&]() {
+        double value = 0;
+        if (!readNumber(value)) {
+            return false;
+        }
+        values.append(value);
+        return true;
+    });
+}
+
+template<typename F>
+bool HeadsetControlParser::parseObject(F onMember)
+{
+    skipWhitespace();
+    if (!consume('{')) {
+        return false;
+    }
+    skipWhitespace();
+    if (consume('}')) {
+        return true;
+    }
+    while (true) {
+        QByteArrayView key;
+        skipWhitespace();
+        if (!readKey(key)) {
+            return false;
+        }
+        skipWhitespace();
+        if (!consume(':')) {
+            return false;
+        }
+        skipWhitespace();
+        if (!onMember(key)) {
+            return false;
+        }
+        skipWhitespace();
+        if (!consume(',')) {
+            return consume('}');
+        }
+    }
+}
+
+template<typename F>
+bool HeadsetControlParser::parseArray(F onElement)
+{
+    skipWhitespace();
+    if (!consume('[')) {
+        return false;
+    }
+    skipWhitespace();
+    if (consume(']')) {
+        return true;
+    }
+    while (true) {
+        skipWhitespace();
+        if (!onElement()) {
+            return false;
+        }
+        skipWhitespace();
+        if (!consume(',')) {
+            return consume(']');
+        }
+    }
+}
+
+bool HeadsetControlParser::readKey(QByteArrayView &key)
+{
+    // Keys are compared raw: headsetcontrol never escapes them
+    if (!consume('"')) {
+        return false;
+    }
+    const char *start = pos;
+    while (pos < end && *pos != '"') {
+        pos += *pos == '\\' ? 2 : 1;
+    }
+    if (pos >= end) {
+        return false;
+    }
+    key = QByteArrayView(start, pos - start);
+    ++pos;
+    return true;
+}
+
+bool HeadsetControlParser::readString(QString &value)
+{
+    if (pos < end && *pos == 'n') {
+        value.clear();
+        return skipValue();
+    }
+    if (!consume('"')) {
+        return false;
+    }
+
+    const char *start = pos;
+    while (pos < end && *pos != '"' && *pos != '\\') {
+        ++pos;
+    }
+    if (pos >= end) {
+        return false;
+    }
+    // Polls repeat the same strings; keeping the one already there saves the allocation
+    if (!holds(value, start, pos - start)) {
+        value = QString::fromUtf8(start, pos - start);
+    }
+    if (*pos == '"') {
+        ++pos;
+        return true;
+    }
+
+    // Slow path, only for strings that contain escapes
+    while (pos < end && *pos != '"') {
+        if (*pos != '\\') {
+            start = pos;
+            while (pos < end && *pos != '"' && *pos != '\\') {
+                ++pos;
+            }
+            value += QString::fromUtf8(start, pos - start);
+            continue;
+        }
+        if (end - pos < 2) {
+            return false;
+        }
+        char escaped = pos[1];
+        pos += 2;
+        switch (escaped) {
+        case 'b':
+            value += QChar('\b');
+            break;
+        case 'f':
+            value += QChar('\f');
+            break;
+        case 'n':
+            value += QChar('\n');
+            break;
+        case 'r':
+            value += QChar('\r');
+            break;
+        case 't':
+            value += QChar('\t');
+            break;
+        case 'u': {
+            if (end - pos < 4) {
+                return false;
+            }
+            bool ok = false;
+            // Surrogate pairs arrive as two escapes and combine in UTF-16 on their own
+            char16_t unit = QByteArray(pos, 4).toUShort(&ok, 16);
+            if (!ok) {
+                return false;
+            }
+            value += QChar(unit);
+            pos += 4;
+            break;
+        }
+        default:
+            value += QChar(escaped);
+            break;
+        }
+    }
+    return consume('"');
+}
+
+bool HeadsetControlParser::readNumber(double &value)
+{
+    if (pos < end && *pos == 'n') {
+        return skipValue();
+    }
+
+    bool negative = consume('-');
+    bool digits = false;
+    double result = 0;
+    while (pos < end && isDigit(*pos)) {
+        result = result * 10 + (*pos++ - '0');
+        digits = true;
+    }
+    if (consume('.')) {
+        double fraction = 0;
+        double scale = 1;
+        while (pos < end && isDigit(*pos)) {
+            fraction = fraction * 10 + (*pos++ - '0');
+            scale *= 10;
+            digits = true;
+        }
+        result += fraction / scale;
+    }
+    if (!digits) {
+        return false;
+    }
+    if (pos < end && (*pos == 'e' || *pos == 'E')) {
+        ++pos;
+        bool negativeExponent = consume('-');
+        if (!negativeExponent) {
+            consume('+');
+        }
+        int exponent = 0;
+        while (pos < end && isDigit(*pos)) {
+            exponent = exponent * 10 + (*pos++ - '0');
+        }
+        result *= std::pow(10.0, negativeExponent ? -exponent : exponent);
+    }
+
+    value = negative ? -result : result;
+    return true;
+}
+
+bool HeadsetControlParser::readInt(int &value)
+{
+    double number = value;
+    if (!readNumber(number)) {
+        return false;
+    }
+    value = static_cast<int>(number);
+    return true;
+}
+
+bool HeadsetControlParser::skipValue()
+{
+    skipWhitespace();
+    if (pos >= end) {
+        return false;
+    }
+    switch (*pos) {
+    case '"':
+        return skipString();
+    case '{':
+        return parseObject([this](QByteArrayView) { return skipValue(); });
+    case '[':
+        return parseArray([this]() { return skipValue(); });
+    case 't':
+    case 'f':
+    case 'n':
+        while (pos < end && *pos >= 'a' && *pos <= 'z') {
+            ++pos;
+        }
+        return true;
+    default:
+        double ignored;
+        return readNumber(ignored);
+    }
+}
+
+bool HeadsetControlParser::skipString()
+{
+    if (!consume('"')) {
+        return false;
+    }
+    while (pos < end && *pos != '"') {
+        pos += *pos == '\\' ? 2 : 1;
+    }
+    return consume('"');
+}
+
+void HeadsetControlParser::skipWhitespace()
+{
+    while (pos < end && (*pos == ' ' || *pos == '\n' || *pos == '\r' || *pos == '\t')) {
+        ++pos;
+    }
+}
+
+bool HeadsetControlParser::consume(char c)
+{
+    if (pos < end && *pos == c) {
+        ++pos;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,73 @@
+#ifndef HEADSETCONTROLPARSER_H
+#define HEADSETCONTROLPARSER_H
+
+#include "command.h"
+#include "device.h"
+#include "devicemetadatacache.h"
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QList>
+#include <QString>
+
+class HeadsetControlOutput
+{
+public:
+    QString name;
+    QString version;
+    QString api_version;
+    QString hidapi_version;
+
+    QList<Device> devices;
+    QList<Action> actions;
+};
+
+// Single forward pass over headsetcontrol's JSON output, straight from the
+// raw stdout bytes into Device/Battery/Action. Object key order is kept as
+// read, which is what equalizer_presets relies on. Static device fields are
+// skipped entirely for VID:PIDs already present in the metadata cache.
+class HeadsetControlParser
+{
+public:
+    explicit HeadsetControlParser(DeviceMetadataCache *metadataCache = nullptr);
+
+    // Returns false on malformed input; output then holds no devices.
+    // Passing the same output on every poll reuses its devices instead of allocating new ones.
+    bool parse(const QByteArray &data, HeadsetControlOutput &output);
+    // Reads only ids, status, battery and chatmix of every device; allocates no Device
+    bool parseStatus(const QByteArray &data, QList<DeviceStatus> &statuses);
+
+private:
+    DeviceMetadataCache *metadataCache;
+
+    const char *pos = nullptr;
+    const char *end = nullptr;
+
+    bool parseRoot(HeadsetControlOutput &output);
+    bool parseDevice(Device &device, bool reused);
+    bool parseDeviceStatus(DeviceStatus &status);
+    bool parseAction(Action &action);
+    bool parseBattery(Battery &battery);
+    bool parseEqualizer(Equalizer &equalizer);
+    bool parseEqualizerPresets(QList<EqualizerPreset> &presets);
+    bool parseStringArray(QSet<QString> &values);
+    bool parseNumberArray(QList<double> &values);
+
+    // Calls onMember(key) for every member; onMember must consume the value and return success
+    template<typename F>
+    bool parseObject(F onMember);
+    template<typename F>
+    bool parseArray(F onElement);
+
+    bool readKey(QByteArrayView &key);
+    bool readString(QString &value);
+    bool readNumber(double &value);
+    bool readInt(int &value);
+    bool skipValue();
+    bool skipString();
+
+    void skipWhitespace();
+    bool consume(char c);
+};
+
+#endif // HEADSETCONTROLPARSER_H
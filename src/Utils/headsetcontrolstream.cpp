@@ -0,0 +1,160 @@
+#include "headsetcontrolstream.h"
+
+#include <QDebug>
+
+HeadsetControlStream::HeadsetControlStream(const QString &headsetcontrolFilePath, QObject *parent)
+    : QObject(parent)
+    , headsetcontrolFilePath(headsetcontrolFilePath)
+    , process(this)
+    , restartTimer(this)
+    , watchdog(this)
+{
+    restartTimer.setSingleShot(true);
+    watchdog.setSingleShot(true);
+
+    connect(&process, &QProcess::readyReadStandardOutput, this, &HeadsetControlStream::readOutput);
+    connect(&process, &QProcess::finished, this, &HeadsetControlStream::processExited);
+    connect(&process, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
+        qDebug() << "Stream error: \t" << error;
+        if (error == QProcess::FailedToStart) {
+            processExited();
+        }
+    });
+    connect(&restartTimer, &QTimer::timeout, this, &HeadsetControlStream::launch);
+    connect(&watchdog, &QTimer::timeout, this, [this]() {
+        qWarning() << "Stream stopped reporting, killing headsetcontrol";
+        process.kill();
+    });
+}
+
+HeadsetControlStream::~HeadsetControlStream()
+{
+    stop();
+}
+
+void HeadsetControlStream::start(int secondsInterval, const QStringList &args_list)
+{
+    if (running && this->secondsInterval == secondsInterval && args == args_list) {
+        return;
+    }
+    stop();
+
+    this->secondsInterval = qMax(1, secondsInterval);
+    args = args_list;
+    running = true;
+    msecRestartDelay = MSEC_MIN_RESTART_DELAY;
+    launch();
+}
+
+void HeadsetControlStream::stop()
+{
+    running = false;
+    restartTimer.stop();
+    watchdog.stop();
+    if (process.state() != QProcess::NotRunning) {
+        process.kill();
+        process.waitForFinished(1000);
+    }
+    resetSplitter();
+}
+
+bool HeadsetControlStream::isRunning() const
+{
+    return running;
+}
+
+int HeadsetControlStream::interval() const
+{
+    return secondsInterval;
+}
+
+void HeadsetControlStream::launch()
+{
+    if (!running || process.state() != QProcess::NotRunning) {
+        return;
+    }
+    resetSplitter();
+
+    QStringList launchArgs = QStringList() << QString("--output") << QString("JSON");
+    launchArgs << QString("--follow=%1").arg(secondsInterval);
+    launchArgs << args;
+
+    qDebug() << "Stream: \t" << headsetcontrolFilePath;
+    qDebug() << "\tArgs: \theadsetcontrol " << launchArgs;
+    process.start(headsetcontrolFilePath, launchArgs);
+    watchdog.start(watchdogTimeout());
+}
+
+int HeadsetControlStream::watchdogTimeout() const
+{
+    // Generous enough for a slow first enumeration on top of the follow interval
+    return (secondsInterval * 3 + 10) * 1000;
+}
+
+void HeadsetControlStream::resetSplitter()
+{
+    buffer.clear();
+    scanPosition = 0;
+    depth = 0;
+    inString = false;
+    escaped = false;
+}
+
+void HeadsetControlStream::readOutput()
+{
+    buffer.append(process.readAllStandardOutput());
+
+    // Documents are concatenated without separators, so track brace depth
+    // (ignoring braces inside strings) and cut whenever it drops back to zero
+    qsizetype documentStart = 0;
+    for (; scanPosition < buffer.size(); ++scanPosition) {
+        char c = buffer.at(scanPosition);
+        if (inString) {
+            if (escaped) {
+                escaped = false;
+            } else if (c == '\\') {
+                escaped = true;
+            } else if (c == '"') {
+                inString = false;
+            }
+            continue;
+        }
+
+        if (c == '"') {
+            inString = true;
+        } else if (c == '{') {
+            if (depth++ == 0) {
+                documentStart = scanPosition;
+            }
+        } else if (c == '}' && depth > 0) {
+            if (--depth == 0) {
+                emit documentReceived(
+                    buffer.sliced(documentStart, scanPosition - documentStart + 1));
+                documentStart = scanPosition + 1;
+                msecRestartDelay = MSEC_MIN_RESTART_DELAY;
+                watchdog.start(watchdogTimeout());
+            }
+        }
+    }
+
+    // Keep only the unfinished document
+    if (depth == 0) {
+        buffer.clear();
+        scanPosition = 0;
+    } else if (documentStart > 0) {
+        buffer.remove(0, documentStart);
+        scanPosition -= documentStart;
+    }
+}
+
+void HeadsetControlStream::processExited()
+{
+    watchdog.stop();
+    if (!running || restartTimer.isActive()) {
+        return;
+    }
+
+    qDebug() << "Stream exited, restarting in" << msecRestartDelay << "ms";
+    restartTimer.start(msecRestartDelay);
+    msecRestartDelay = qMin(msecRestartDelay * 2, MSEC_MAX_RESTART_DELAY);
+}
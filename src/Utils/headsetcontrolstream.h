@@ -0,0 +1,58 @@
+#ifndef HEADSETCONTROLSTREAM_H
+#define HEADSETCONTROLSTREAM_H
+
+#include <QByteArray>
+#include <QObject>
+#include <QProcess>
+#include <QTimer>
+
+// Keeps a single headsetcontrol child alive in --follow mode and splits its
+// stdout into the JSON documents it prints on every iteration
+class HeadsetControlStream : public QObject
+{
+    Q_OBJECT
+
+public:
+    HeadsetControlStream(const QString &headsetcontrolFilePath, QObject *parent = nullptr);
+    ~HeadsetControlStream();
+
+    void start(int secondsInterval, const QStringList &args_list = QStringList());
+    void stop();
+
+    bool isRunning() const;
+    int interval() const;
+
+signals:
+    void documentReceived(const QByteArray &document);
+
+private:
+    static constexpr int MSEC_MIN_RESTART_DELAY = 1000;
+    static constexpr int MSEC_MAX_RESTART_DELAY = 60000;
+
+    QString headsetcontrolFilePath;
+    QStringList args;
+    int secondsInterval = 0;
+    bool running = false;
+
+    // Parented to the stream so they follow it to another thread
+    QProcess process;
+    QTimer restartTimer;
+    // Kills a child that stopped reporting so it gets restarted
+    QTimer watchdog;
+    int msecRestartDelay = MSEC_MIN_RESTART_DELAY;
+
+    // Incremental document splitter state
+    QByteArray buffer;
+    qsizetype scanPosition = 0;
+    int depth = 0;
+    bool inString = false;
+    bool escaped = false;
+
+    void launch();
+    int watchdogTimeout() const;
+    void resetSplitter();
+    void readOutput();
+    void processExited();
+};
+
+#endif // HEADSETCONTROLSTREAM_H
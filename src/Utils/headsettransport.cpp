@@ -0,0 +1,37 @@
+#include "headsettransport.h"
+
+HeadsetTransport::HeadsetTransport(QObject *parent)
+    : QObject(parent)
+{}
+
+void HeadsetTransport::startFollowing(int secondsInterval)
+{
+    Q_UNUSED(secondsInterval);
+}
+
+void HeadsetTransport::stopFollowing() {}
+
+bool HeadsetTransport::isFollowing() const
+{
+    return false;
+}
+
+QString HeadsetTransport::getName() const
+{
+    return name;
+}
+
+QVersionNumber HeadsetTransport::getVersion() const
+{
+    return version;
+}
+
+QVersionNumber HeadsetTransport::getApiVersion() const
+{
+    return api_version;
+}
+
+QVersionNumber HeadsetTransport::getHidApiVersion() const
+{
+    return hidapi_version;
+}
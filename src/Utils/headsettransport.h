@@ -0,0 +1,49 @@
+#ifndef HEADSETTRANSPORT_H
+#define HEADSETTRANSPORT_H
+
+#include "command.h"
+#include "device.h"
+
+#include <QFuture>
+#include <QObject>
+#include <QVersionNumber>
+
+// How HeadsetControlAPI reaches the hardware. Implementations return ready
+// Device values, so nothing above this layer knows about processes or JSON.
+class HeadsetTransport : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit HeadsetTransport(QObject *parent = nullptr);
+
+    // Whether the backend can be used at all (e.g. the headsetcontrol binary exists)
+    virtual bool isAvailable() const = 0;
+
+    virtual QFuture<QList<Device>> enumerate() = 0;
+    // Battery, chatmix and status of the attached devices, without a full enumeration
+    virtual QFuture<QList<DeviceStatus>> status() = 0;
+    // Resolves to one Action per command that the backend reported on
+    virtual QFuture<QList<Action>> apply(const QList<Command> &commands) = 0;
+
+    // Backends that can push updates emit statusUpdated() while following
+    virtual void startFollowing(int secondsInterval);
+    virtual void stopFollowing();
+    virtual bool isFollowing() const;
+
+    QString getName() const;
+    QVersionNumber getVersion() const;
+    QVersionNumber getApiVersion() const;
+    QVersionNumber getHidApiVersion() const;
+
+protected:
+    QString name;
+    QVersionNumber version;
+    QVersionNumber api_version;
+    QVersionNumber hidapi_version;
+
+signals:
+    void statusUpdated(const QList<DeviceStatus> &statuses);
+};
+
+#endif // HEADSETTRANSPORT_H
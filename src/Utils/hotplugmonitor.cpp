@@ -0,0 +1,63 @@
+#include "hotplugmonitor.h"
+
+#include <QDir>
+
+HotplugMonitor::HotplugMonitor(const QString &watchRoot, QObject *parent)
+    : QObject(parent)
+    , watchRoot(watchRoot)
+{
+    settleTimer.setSingleShot(true);
+    connect(&settleTimer, &QTimer::timeout, this, &HotplugMonitor::checkNodes);
+    connect(&watcher, &QFileSystemWatcher::directoryChanged, this, &HotplugMonitor::rootChanged);
+
+#ifdef Q_OS_LINUX
+    available = QDir(watchRoot).exists() && watcher.addPath(watchRoot);
+#endif
+    if (available) {
+        nodes = listNodes();
+    } else {
+        qDebug() << "Hotplug monitor unavailable, falling back to polling";
+    }
+}
+
+bool HotplugMonitor::isAvailable() const
+{
+    return available;
+}
+
+QString HotplugMonitor::getWatchRoot() const
+{
+    return watchRoot;
+}
+
+QString HotplugMonitor::defaultWatchRoot()
+{
+    QString root = qEnvironmentVariable("HEADSETCONTROL_GUI_HOTPLUG_ROOT");
+    return root.isEmpty() ? QString("/dev") : root;
+}
+
+QSet<QString> HotplugMonitor::listNodes() const
+{
+    QStringList list = QDir(watchRoot).entryList(QStringList() << "hidraw*",
+                                                 QDir::System | QDir::Files
+                                                     | QDir::NoDotAndDotDot);
+    return QSet<QString>(list.begin(), list.end());
+}
+
+void HotplugMonitor::rootChanged()
+{
+    // Anything else under the root changing restarts the delay too, which is harmless
+    settleTimer.start(MSEC_SETTLE_DELAY);
+}
+
+void HotplugMonitor::checkNodes()
+{
+    QSet<QString> current = listNodes();
+    if (current == nodes) {
+        return;
+    }
+
+    qDebug() << "HID nodes changed:" << current.size() << "present";
+    nodes = current;
+    emit devicesChanged();
+}
@@ -0,0 +1,46 @@
+#ifndef HOTPLUGMONITOR_H
+#define HOTPLUGMONITOR_H
+
+#include <QFileSystemWatcher>
+#include <QObject>
+#include <QSet>
+#include <QTimer>
+
+// Watches the hidraw nodes under watchRoot (normally /dev) and emits
+// devicesChanged() when one appears or disappears, so devices only get
+// enumerated when something was actually plugged or unplugged.
+// Only Linux exposes hidraw nodes: elsewhere isAvailable() is false and
+// callers have to keep polling.
+class HotplugMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit HotplugMonitor(const QString &watchRoot = defaultWatchRoot(),
+                            QObject *parent = nullptr);
+
+    bool isAvailable() const;
+    QString getWatchRoot() const;
+
+    // HEADSETCONTROL_GUI_HOTPLUG_ROOT overrides /dev, e.g. with a temporary directory
+    static QString defaultWatchRoot();
+
+signals:
+    void devicesChanged();
+
+private:
+    // Nodes show up a moment before udev fixes their permissions
+    static constexpr int MSEC_SETTLE_DELAY = 500;
+
+    QString watchRoot;
+    QFileSystemWatcher watcher;
+    QTimer settleTimer;
+    QSet<QString> nodes;
+    bool available = false;
+
+    QSet<QString> listNodes() const;
+    void rootChanged();
+    void checkNodes();
+};
+
+#endif // HOTPLUGMONITOR_H
@@ -0,0 +1,272 @@
+#include "inputreportlistener.h"
+
+#include <QDir>
+#include <QFile>
+#include <QRegularExpression>
+
+#include <algorithm>
+
+#ifdef Q_OS_UNIX
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+// SteelSeries Arctis Nova 7 family: the dongle pushes 0x45 when the chatmix
+// dial moves and answers the 0xb0 status request headsetcontrol sends with the battery
+static bool decodeArctisNova7(const QByteArray &report, ReportUpdate &update)
+{
+    if (report.size() >= 3 && quint8(report.at(0)) == 0x45) {
+        int game = quint8(report.at(1));
+        int chat = quint8(report.at(2));
+        // Same mapping as headsetcontrol: 0..128, 64 is balanced
+        update.has_chatmix = true;
+        update.chatmix = 64 - game * 64 / 100 + chat * 64 / 100;
+        return true;
+    }
+    if (report.size() >= 4 && quint8(report.at(0)) == 0xb0) {
+        int level = quint8(report.at(2));
+        int status = quint8(report.at(3));
+        update.has_battery = true;
+        if (status == 0x00) {
+            update.battery = Battery("BATTERY_UNAVAILABLE", -1);
+        } else {
+            update.battery = Battery(status == 0x01 ? "BATTERY_CHARGING" : "BATTERY_AVAILABLE",
+                                     qBound(0, level, 4) * 25);
+        }
+        return true;
+    }
+    return false;
+}
+
+// Interface and usage page are the ones headsetcontrol talks to for these models
+static const ReportDecoder decoders[] = {
+    {0x1038, 0x2202, 3, 0xffc0, decodeArctisNova7},
+    {0x1038, 0x2206, 3, 0xffc0, decodeArctisNova7},
+    {0x1038, 0x220a, 3, 0xffc0, decodeArctisNova7},
+    {0x1038, 0x223a, 3, 0xffc0, decodeArctisNova7},
+};
+
+const ReportDecoder *ReportDecoder::find(quint16 id_vendor, quint16 id_product)
+{
+    for (const ReportDecoder &decoder : decoders) {
+        if (decoder.id_vendor == id_vendor && decoder.id_product == id_product) {
+            return &decoder;
+        }
+    }
+    return nullptr;
+}
+
+InputReportListener::InputReportListener(QObject *parent)
+    : QObject(parent)
+{}
+
+InputReportListener::~InputReportListener()
+{
+    stop();
+}
+
+bool InputReportListener::startDevice(const QString &id_vendor,
+                                      const QString &id_product,
+                                      const QString &sysfsRoot)
+{
+    stop();
+
+    quint16 vendor = DeviceKey::parseId(id_vendor);
+    quint16 product = DeviceKey::parseId(id_product);
+    const ReportDecoder *decoder = ReportDecoder::find(vendor, product);
+    if (decoder == nullptr) {
+        return false;
+    }
+
+    QString node = findHidrawNode(*decoder, sysfsRoot);
+    if (node.isEmpty()) {
+        return false;
+    }
+
+#ifdef Q_OS_UNIX
+    int nodeFd = ::open(QFile::encodeName(node).constData(), O_RDONLY | O_CLOEXEC);
+    if (nodeFd < 0) {
+        qDebug() << "Unable to open" << node << "for input reports";
+        return false;
+    }
+    qDebug() << "Listening for input reports on" << node;
+    return start(nodeFd, decoder);
+#else
+    return false;
+#endif
+}
+
+bool InputReportListener::start(int fd, const ReportDecoder *decoder)
+{
+    stop();
+
+#ifdef Q_OS_UNIX
+    if (::pipe(wakePipe) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    this->fd = fd;
+    this->decoder = decoder;
+    thread = QThread::create([this]() { readLoop(); });
+    thread->setObjectName("InputReportListener");
+    thread->start();
+    return true;
+#else
+    Q_UNUSED(fd);
+    Q_UNUSED(decoder);
+    return false;
+#endif
+}
+
+void InputReportListener::stop()
+{
+    if (thread == nullptr) {
+        return;
+    }
+
+#ifdef Q_OS_UNIX
+    char wake = 0;
+    if (::write(wakePipe[1], &wake, 1) < 0) {
+        qWarning() << "Unable to wake the input report thread";
+    }
+    thread->wait();
+
+    ::close(fd);
+    ::close(wakePipe[0]);
+    ::close(wakePipe[1]);
+#endif
+
+    delete thread;
+    thread = nullptr;
+    fd = -1;
+    wakePipe[0] = wakePipe[1] = -1;
+    decoder = nullptr;
+}
+
+bool InputReportListener::isRunning() const
+{
+    return thread != nullptr && thread->isRunning();
+}
+
+// Whether the report descriptor declares usagePage anywhere
+static bool declaresUsagePage(const QByteArray &descriptor, quint16 usagePage)
+{
+    int i = 0;
+    while (i < descriptor.size()) {
+        quint8 prefix = quint8(descriptor.at(i));
+        if (prefix == 0xfe) {
+            // Long item: size, tag, data
+            if (i + 1 >= descriptor.size()) {
+                break;
+            }
+            i += 3 + quint8(descriptor.at(i + 1));
+            continue;
+        }
+        int size = (prefix & 0x03) == 3 ? 4 : prefix & 0x03;
+        // Global item, tag 0: Usage Page
+        if ((prefix & 0xfc) == 0x04 && size >= 2 && i + 2 < descriptor.size()) {
+            quint16 page = quint8(descriptor.at(i + 1)) | quint8(descriptor.at(i + 2)) << 8;
+            if (page == usagePage) {
+                return true;
+            }
+        }
+        i += 1 + size;
+    }
+    return false;
+}
+
+QString InputReportListener::findHidrawNode(const ReportDecoder &decoder,
+                                            const QString &sysfsRoot)
+{
+    // uevent holds e.g. "HID_ID=0003:00001038:00002202" and
+    // "HID_PHYS=usb-0000:00:14.0-2/input3"
+    QString id = QString("%1:%2")
+                     .arg(decoder.id_vendor, 8, 16, QChar('0'))
+                     .arg(decoder.id_product, 8, 16, QChar('0'))
+                     .toUpper();
+    QString interface = QString("/input%1").arg(decoder.interface_number);
+
+    QDir root(sysfsRoot);
+    QStringList nodes = root.entryList(QStringList() << "hidraw*",
+                                       QDir::Dirs | QDir::System | QDir::NoDotAndDotDot);
+    // hidraw2 before hidraw10
+    std::sort(nodes.begin(), nodes.end(), [](const QString &a, const QString &b) {
+        return a.mid(6).toInt() < b.mid(6).toInt();
+    });
+
+    for (const QString &node : std::as_const(nodes)) {
+        QFile uevent(root.filePath(node + "/device/uevent"));
+        if (!uevent.open(QIODevice::ReadOnly)) {
+            continue;
+        }
+        bool sameId = false;
+        QString phys;
+        for (const QByteArray &line : uevent.readAll().split('\n')) {
+            if (line.startsWith("HID_ID=")) {
+                sameId = QString::fromLatin1(line).toUpper().endsWith(id);
+            } else if (line.startsWith("HID_PHYS=")) {
+                phys = QString::fromLatin1(line.mid(9)).trimmed();
+            }
+        }
+        if (!sameId) {
+            continue;
+        }
+
+        // USB nodes name their interface; others (e.g. Bluetooth) only show it in what
+        // they report
+        static const QRegularExpression inputSuffix("/input\\d+$");
+        if (inputSuffix.match(phys).hasMatch()) {
+            if (phys.endsWith(interface)) {
+                return "/dev/" + node;
+            }
+            continue;
+        }
+        QFile descriptor(root.filePath(node + "/device/report_descriptor"));
+        if (descriptor.open(QIODevice::ReadOnly)
+            && declaresUsagePage(descriptor.readAll(), decoder.usage_page)) {
+            return "/dev/" + node;
+        }
+    }
+    return QString();
+}
+
+void InputReportListener::readLoop()
+{
+#ifdef Q_OS_UNIX
+    char buffer[MAX_REPORT_SIZE];
+    pollfd fds[2] = {{fd, POLLIN, 0}, {wakePipe[0], POLLIN, 0}};
+
+    while (true) {
+        if (::poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (fds[1].revents != 0) {
+            break;
+        }
+        if (fds[0].revents == 0) {
+            continue;
+        }
+
+        // hidraw returns exactly one report per read
+        ssize_t size = ::read(fd, buffer, sizeof(buffer));
+        if (size < 0 && errno == EINTR) {
+            continue;
+        }
+        if (size <= 0) {
+            // Unplugged, or the writing end of a pipe went away
+            break;
+        }
+
+        ReportUpdate update;
+        if (decoder->decode(QByteArray(buffer, size), update)) {
+            emit reportDecoded(update);
+        }
+    }
+#endif
+}
@@ -0,0 +1,81 @@
+#ifndef INPUTREPORTLISTENER_H
+#define INPUTREPORTLISTENER_H
+
+#include "device.h"
+
+#include <QByteArray>
+#include <QObject>
+#include <QThread>
+
+// What a single input report told us; only the flagged values are meaningful
+class ReportUpdate
+{
+public:
+    bool has_battery = false;
+    Battery battery;
+    bool has_chatmix = false;
+    int chatmix = 65;
+};
+
+// Turns the raw input reports of one headset model into ReportUpdates
+class ReportDecoder
+{
+public:
+    quint16 id_vendor;
+    quint16 id_product;
+    // Headsets expose several HID interfaces with the same VID:PID; the reports come
+    // from the one with this USB interface number and vendor-defined usage page
+    int interface_number;
+    quint16 usage_page;
+    bool (*decode)(const QByteArray &report, ReportUpdate &update);
+
+    // Returns nullptr for headsets whose reports we don't know
+    static const ReportDecoder *find(quint16 id_vendor, quint16 id_product);
+};
+
+// Reads input reports from a file descriptor on a dedicated thread and emits
+// reportDecoded() for every one the decoder understands. The descriptor is
+// normally the headset's hidraw node, but anything readable works, e.g. the
+// read end of a pipe fed with recorded reports.
+// hidraw hands every report to all readers, so this doesn't steal anything
+// from headsetcontrol.
+class InputReportListener : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit InputReportListener(QObject *parent = nullptr);
+    ~InputReportListener();
+
+    // Looks up the hidraw node for the VID:PID (ids as printed by headsetcontrol, e.g. "0x1038")
+    // and starts reading it. Returns false when the headset has no decoder or no readable node.
+    bool startDevice(const QString &id_vendor,
+                     const QString &id_product,
+                     const QString &sysfsRoot = QString("/sys/class/hidraw"));
+    // Takes ownership of fd
+    bool start(int fd, const ReportDecoder *decoder);
+    void stop();
+    bool isRunning() const;
+
+    // Returns the /dev path of the decoder's hidraw node, or an empty string. Nodes are
+    // matched on HID_ID and then on the interface in HID_PHYS or, when that has none, on
+    // the usage page in the report descriptor.
+    static QString findHidrawNode(const ReportDecoder &decoder, const QString &sysfsRoot);
+
+signals:
+    // Emitted from the reader thread; connections to GUI objects are queued
+    void reportDecoded(const ReportUpdate &update);
+
+private:
+    static constexpr int MAX_REPORT_SIZE = 64;
+
+    QThread *thread = nullptr;
+    int fd = -1;
+    // Written to by stop() to wake the reader out of poll()
+    int wakePipe[2] = {-1, -1};
+    const ReportDecoder *decoder = nullptr;
+
+    void readLoop();
+};
+
+#endif // INPUTREPORTLISTENER_H
@@ -0,0 +1,72 @@
+#include "pollscheduler.h"
+
+PollScheduler::PollScheduler()
+{
+    clock.start();
+}
+
+void PollScheduler::setIntervals(int msecMin, int msecDefault, int msecMax)
+{
+    this->msecMin = qMax(1000, msecMin);
+    this->msecMax = qMax(this->msecMin, msecMax);
+    this->msecDefault = qBound(this->msecMin, msecDefault, this->msecMax);
+}
+
+void PollScheduler::setBatteryLowThreshold(int level)
+{
+    batteryLowThreshold = level;
+}
+
+int PollScheduler::nextInterval(const Device *device, bool devicesFound)
+{
+    return nextInterval(device, devicesFound, clock.elapsed());
+}
+
+int PollScheduler::nextInterval(const Device *device, bool devicesFound, qint64 msecNow)
+{
+    if (device == nullptr) {
+        lastLevel = -1;
+        lastStatus.clear();
+        if (devicesFound) {
+            missedPolls = 0;
+            return msecDefault;
+        }
+        // Nothing plugged in: double the delay each time, up to the upper bound
+        int msec = msecDefault;
+        for (int i = 0; i < missedPolls && msec < msecMax; ++i) {
+            msec *= 2;
+        }
+        missedPolls++;
+        return qMin(msec, msecMax);
+    }
+
+    missedPolls = 0;
+    if (device->battery.level != lastLevel || device->battery.status != lastStatus) {
+        lastLevel = device->battery.level;
+        lastStatus = device->battery.status;
+        msecLastChange = msecNow;
+    }
+    return intervalFor(device->battery, msecNow - msecLastChange);
+}
+
+void PollScheduler::reset()
+{
+    missedPolls = 0;
+    lastLevel = -1;
+    lastStatus.clear();
+}
+
+int PollScheduler::intervalFor(const Battery &battery, qint64 msecUnchanged) const
+{
+    if (battery.status == "BATTERY_CHARGING") {
+        return battery.level < 100 ? msecMin : msecMax;
+    }
+    if (battery.status == "BATTERY_AVAILABLE") {
+        if (battery.level <= batteryLowThreshold + LOW_BATTERY_MARGIN) {
+            return msecMin;
+        }
+        return msecUnchanged >= MSEC_STABLE_AFTER ? msecMax : msecDefault;
+    }
+    // Headset off, or a device without battery reporting
+    return msecMax;
+}
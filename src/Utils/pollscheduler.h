@@ -0,0 +1,46 @@
+#ifndef POLLSCHEDULER_H
+#define POLLSCHEDULER_H
+
+#include "device.h"
+
+#include <QElapsedTimer>
+
+// Picks the delay before the next status poll from what the last ones showed:
+// fast near the low battery threshold or while charging, slow while the level
+// hasn't moved for a long time or the headset is off, and exponentially slower
+// while no device is found.
+class PollScheduler
+{
+public:
+    PollScheduler();
+
+    // msecMin and msecMax bound every delay, msecDefault is used while the battery drains
+    void setIntervals(int msecMin, int msecDefault, int msecMax);
+    void setBatteryLowThreshold(int level);
+
+    int nextInterval(const Device *device, bool devicesFound);
+    // Same, at msecNow on a monotonic clock of the caller's choosing
+    int nextInterval(const Device *device, bool devicesFound, qint64 msecNow);
+    void reset();
+
+private:
+    static constexpr int LOW_BATTERY_MARGIN = 5;
+    // A draining headset loses 1% every few minutes; a level that stays put much
+    // longer than that belongs to one that is idle or not draining at all
+    static constexpr qint64 MSEC_STABLE_AFTER = 20 * 60 * 1000;
+
+    int msecMin = 5000;
+    int msecDefault = 30000;
+    int msecMax = 120000;
+    int batteryLowThreshold = 15;
+
+    QElapsedTimer clock;
+    int missedPolls = 0;
+    int lastLevel = -1;
+    QString lastStatus;
+    qint64 msecLastChange = 0;
+
+    int intervalFor(const Battery &battery, qint64 msecUnchanged) const;
+};
+
+#endif // POLLSCHEDULER_H
@@ -0,0 +1,538 @@
+#include "presetlibrary.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QHash>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <QSet>
+#include <QTextStream>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Index layout, all integers little endian:
+//   header   magic[8] version:u32 entries:u32 keys:u32 root:(u32 offset, u32 length) reserved:u32
+//   entries  model, name, relative path as (u32 offset, u32 length) each, mtime:i64,
+//            format:u8, padding to ENTRY_SIZE
+//   keys     (u32 offset, u32 length) of the case-folded key, entry:u32; sorted by key bytes
+//   pool     UTF-8 strings the offsets above point into
+
+static constexpr double PI = 3.14159265358979323846;
+// Butterworth Q, for filters that don't give one
+static constexpr double DEFAULT_Q = 0.70710678118654752;
+
+static quint32 read32(const uchar *data)
+{
+    return qFromLittleEndian<quint32>(data);
+}
+
+static void append32(QByteArray &data, quint32 value)
+{
+    char bytes[4];
+    qToLittleEndian(value, bytes);
+    data.append(bytes, 4);
+}
+
+static void append64(QByteArray &data, qint64 value)
+{
+    char bytes[8];
+    qToLittleEndian(value, bytes);
+    data.append(bytes, 8);
+}
+
+static int compareBytes(const QByteArray &a, const char *b, quint32 bLength)
+{
+    int result = std::memcmp(a.constData(), b, std::min<size_t>(a.size(), bLength));
+    if (result != 0) {
+        return result;
+    }
+    return a.size() < qsizetype(bLength) ? -1 : (a.size() > qsizetype(bLength) ? 1 : 0);
+}
+
+PresetLibrary::PresetLibrary(const QString &indexFilePath)
+    : indexFile(indexFilePath)
+{
+    open();
+}
+
+PresetLibrary::~PresetLibrary()
+{
+    close();
+}
+
+QString PresetLibrary::getRoot() const
+{
+    return root;
+}
+
+int PresetLibrary::size() const
+{
+    return entryCount;
+}
+
+bool PresetLibrary::open()
+{
+    close();
+    if (!indexFile.exists() || !indexFile.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    mapSize = indexFile.size();
+    map = mapSize >= HEADER_SIZE ? indexFile.map(0, mapSize) : nullptr;
+    if (map == nullptr || std::memcmp(map, MAGIC, sizeof(MAGIC)) != 0
+        || read32(map + 8) != INDEX_VERSION) {
+        qWarning() << "Ignoring unreadable preset index" << indexFile.fileName();
+        close();
+        return false;
+    }
+
+    entryCount = read32(map + 12);
+    keyCount = read32(map + 16);
+    poolOffset = HEADER_SIZE + qint64(entryCount) * ENTRY_SIZE + qint64(keyCount) * KEY_SIZE;
+    if (poolOffset > mapSize) {
+        qWarning() << "Ignoring truncated preset index" << indexFile.fileName();
+        close();
+        return false;
+    }
+    root = QString::fromUtf8(stringAt(map + 20));
+    return true;
+}
+
+void PresetLibrary::close()
+{
+    if (map != nullptr) {
+        indexFile.unmap(const_cast<uchar *>(map));
+        map = nullptr;
+    }
+    indexFile.close();
+    mapSize = 0;
+    entryCount = 0;
+    keyCount = 0;
+    poolOffset = 0;
+    root.clear();
+}
+
+QString PresetLibrary::builtFilePath() const
+{
+    return indexFile.fileName() + ".new";
+}
+
+const uchar *PresetLibrary::entryRecord(quint32 index) const
+{
+    return map + HEADER_SIZE + qint64(index) * ENTRY_SIZE;
+}
+
+const uchar *PresetLibrary::keyRecord(quint32 index) const
+{
+    return map + HEADER_SIZE + qint64(entryCount) * ENTRY_SIZE + qint64(index) * KEY_SIZE;
+}
+
+QByteArray PresetLibrary::stringAt(const uchar *record) const
+{
+    quint32 offset = read32(record);
+    quint32 length = read32(record + 4);
+    if (poolOffset + offset + length > mapSize) {
+        return QByteArray();
+    }
+    return QByteArray(reinterpret_cast<const char *>(map + poolOffset + offset), length);
+}
+
+PresetLibrary::Entry PresetLibrary::entryAt(quint32 index) const
+{
+    const uchar *record = entryRecord(index);
+    Entry entry;
+    entry.model = QString::fromUtf8(stringAt(record));
+    entry.name = QString::fromUtf8(stringAt(record + 8));
+    entry.filePath = root + "/" + QString::fromUtf8(stringAt(record + 16));
+    entry.format = Format(record[32]);
+    return entry;
+}
+
+QList<PresetLibrary::Entry> PresetLibrary::search(const QString &prefix, int limit) const
+{
+    QList<Entry> results;
+    if (map == nullptr) {
+        return results;
+    }
+    QByteArray needle = prefix.trimmed().toCaseFolded().toUtf8();
+
+    auto keyData = [this](quint32 index, quint32 &length) {
+        const uchar *record = keyRecord(index);
+        quint32 offset = read32(record);
+        length = read32(record + 4);
+        if (poolOffset + offset + length > mapSize) {
+            offset = 0;
+            length = 0;
+        }
+        return reinterpret_cast<const char *>(map + poolOffset + offset);
+    };
+
+    // First key not sorting before the prefix
+    quint32 low = 0;
+    quint32 high = keyCount;
+    while (low < high) {
+        quint32 middle = low + (high - low) / 2;
+        quint32 length;
+        const char *key = keyData(middle, length);
+        if (compareBytes(needle, key, length) > 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    // A preset can match on both its model and its name
+    QSet<quint32> seen;
+    for (quint32 i = low; i < keyCount && results.size() < limit; ++i) {
+        quint32 length;
+        const char *key = keyData(i, length);
+        if (length < quint32(needle.size())
+            || std::memcmp(key, needle.constData(), needle.size()) != 0) {
+            break;
+        }
+        quint32 entry = read32(keyRecord(i) + 8);
+        if (entry < entryCount && !seen.contains(entry)) {
+            seen.insert(entry);
+            results.append(entryAt(entry));
+        }
+    }
+    return results;
+}
+
+bool PresetLibrary::build(const QString &root, int *reread) const
+{
+    const QString cleanRoot = QDir::cleanPath(QDir(root).absolutePath());
+    const QDir rootDir(cleanRoot);
+    if (!rootDir.exists()) {
+        return false;
+    }
+
+    // What the current index knows about each file, if it covers the same tree
+    QHash<QString, quint32> indexed;
+    if (map != nullptr && this->root == cleanRoot) {
+        indexed.reserve(entryCount);
+        for (quint32 i = 0; i < entryCount; ++i) {
+            indexed.insert(QString::fromUtf8(stringAt(entryRecord(i) + 16)), i);
+        }
+    }
+
+    class ScannedFile
+    {
+    public:
+        QByteArray model;
+        QByteArray name;
+        QByteArray path;
+        qint64 modified;
+        Format format;
+    };
+    QList<ScannedFile> files;
+    int opened = 0;
+
+    QDirIterator it(cleanRoot,
+                    QStringList() << "*.txt" << "*.csv",
+                    QDir::Files,
+                    QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        QString filePath = it.next();
+        QFileInfo info = it.fileInfo();
+        QString relativePath = rootDir.relativeFilePath(filePath);
+
+        ScannedFile file;
+        file.model = info.dir().dirName().toUtf8();
+        file.name = info.completeBaseName().toUtf8();
+        file.path = relativePath.toUtf8();
+        file.modified = info.lastModified().toMSecsSinceEpoch();
+
+        auto known = indexed.constFind(relativePath);
+        const uchar *record = known != indexed.constEnd() ? entryRecord(*known) : nullptr;
+        if (record != nullptr && qFromLittleEndian<qint64>(record + 24) == file.modified) {
+            file.format = Format(record[32]);
+        } else {
+            file.format = detectFormat(filePath);
+            opened++;
+        }
+        // Unknown files stay indexed, without keys, so they aren't sniffed again
+        files.append(file);
+    }
+
+    // Entries and the string pool
+    QByteArray pool;
+    QByteArray entries;
+    entries.reserve(files.size() * ENTRY_SIZE);
+    auto appendString = [&pool](QByteArray &data, const QByteArray &string) {
+        append32(data, pool.size());
+        append32(data, string.size());
+        pool.append(string);
+    };
+
+    QByteArray header;
+    header.append(MAGIC, sizeof(MAGIC));
+    append32(header, INDEX_VERSION);
+    append32(header, files.size());
+
+    QList<QPair<QByteArray, quint32>> keys;
+    for (int i = 0; i < files.size(); ++i) {
+        const ScannedFile &file = files.at(i);
+        appendString(entries, file.model);
+        appendString(entries, file.name);
+        appendString(entries, file.path);
+        append64(entries, file.modified);
+        entries.append(char(file.format));
+        entries.append(ENTRY_SIZE - 33, '\0');
+
+        if (file.format == Unknown) {
+            continue;
+        }
+        QByteArray model = QString::fromUtf8(file.model).toCaseFolded().toUtf8();
+        QByteArray name = QString::fromUtf8(file.name).toCaseFolded().toUtf8();
+        keys.append({model, quint32(i)});
+        if (name != model) {
+            keys.append({name, quint32(i)});
+        }
+    }
+    std::sort(keys.begin(), keys.end(), [](const auto &a, const auto &b) {
+        return compareBytes(a.first, b.first.constData(), b.first.size()) < 0;
+    });
+
+    append32(header, keys.size());
+    QByteArray keyTable;
+    keyTable.reserve(keys.size() * KEY_SIZE);
+    for (const auto &key : std::as_const(keys)) {
+        appendString(keyTable, key.first);
+        append32(keyTable, key.second);
+    }
+    appendString(header, cleanRoot.toUtf8());
+    append32(header, 0);
+
+    // The current index stays mapped for searches until publish()
+    QSaveFile file(builtFilePath());
+    bool saved = file.open(QIODevice::WriteOnly);
+    if (saved) {
+        file.write(header);
+        file.write(entries);
+        file.write(keyTable);
+        file.write(pool);
+        saved = file.commit();
+    }
+    if (!saved) {
+        qWarning() << "Couldn't save preset index" << file.fileName();
+        return false;
+    }
+
+    qDebug() << "Preset library:" << files.size() << "files," << opened << "read again";
+    if (reread != nullptr) {
+        *reread = opened;
+    }
+    return true;
+}
+
+bool PresetLibrary::publish()
+{
+    QString builtPath = builtFilePath();
+    if (!QFile::exists(builtPath)) {
+        return false;
+    }
+    // The mapping has to go before the file can be replaced
+    close();
+    QFile::remove(indexFile.fileName());
+    if (!QFile::rename(builtPath, indexFile.fileName())) {
+        qWarning() << "Couldn't replace preset index" << indexFile.fileName();
+    }
+    return open();
+}
+
+bool PresetLibrary::scan(const QString &root, int *reread)
+{
+    return build(root, reread) && publish();
+}
+
+PresetLibrary::Format PresetLibrary::detectFormat(const QString &filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return Unknown;
+    }
+
+    // The format shows within the first few lines
+    QTextStream stream(&file);
+    QString line;
+    for (int i = 0; i < 20 && stream.readLineInto(&line); ++i) {
+        line = line.trimmed();
+        if (line.startsWith("GraphicEQ:")) {
+            return GraphicEq;
+        }
+        if (line.startsWith("Filter") && line.contains(" Fc ")) {
+            return Parametric;
+        }
+        if (line.startsWith("frequency", Qt::CaseInsensitive)) {
+            return Csv;
+        }
+        QStringList fields = line.split(QRegularExpression("[,;\\s]+"), Qt::SkipEmptyParts);
+        bool frequencyOk = false;
+        bool gainOk = false;
+        if (fields.size() >= 2) {
+            fields.at(0).toDouble(&frequencyOk);
+            fields.at(1).toDouble(&gainOk);
+        }
+        if (frequencyOk && gainOk) {
+            return Csv;
+        }
+    }
+    return Unknown;
+}
+
+// Magnitude in dB of an RBJ cookbook biquad at frequency, for a 48 kHz sample rate
+static double filterResponse(
+    const QString &type, double fc, double gain, double q, double frequency)
+{
+    const double sampleRate = 48000;
+    double a = std::pow(10, gain / 40);
+    double w0 = 2 * PI * fc / sampleRate;
+    double cosW0 = std::cos(w0);
+    double alpha = std::sin(w0) / (2 * q);
+    double sqrtA2Alpha = 2 * std::sqrt(a) * alpha;
+
+    double b0, b1, b2, a0, a1, a2;
+    if (type.startsWith("LS")) {
+        b0 = a * ((a + 1) - (a - 1) * cosW0 + sqrtA2Alpha);
+        b1 = 2 * a * ((a - 1) - (a + 1) * cosW0);
+        b2 = a * ((a + 1) - (a - 1) * cosW0 - sqrtA2Alpha);
+        a0 = (a + 1) + (a - 1) * cosW0 + sqrtA2Alpha;
+        a1 = -2 * ((a - 1) + (a + 1) * cosW0);
+        a2 = (a + 1) + (a - 1) * cosW0 - sqrtA2Alpha;
+    } else if (type.startsWith("HS")) {
+        b0 = a * ((a + 1) + (a - 1) * cosW0 + sqrtA2Alpha);
+        b1 = -2 * a * ((a - 1) + (a + 1) * cosW0);
+        b2 = a * ((a + 1) + (a - 1) * cosW0 - sqrtA2Alpha);
+        a0 = (a + 1) - (a - 1) * cosW0 + sqrtA2Alpha;
+        a1 = 2 * ((a - 1) - (a + 1) * cosW0);
+        a2 = (a + 1) - (a - 1) * cosW0 - sqrtA2Alpha;
+    } else {
+        b0 = 1 + alpha * a;
+        b1 = -2 * cosW0;
+        b2 = 1 - alpha * a;
+        a0 = 1 + alpha / a;
+        a1 = -2 * cosW0;
+        a2 = 1 - alpha / a;
+    }
+
+    double w = 2 * PI * frequency / sampleRate;
+    double cosW = std::cos(w);
+    double cos2W = std::cos(2 * w);
+    double numerator = b0 * b0 + b1 * b1 + b2 * b2 + 2 * (b0 * b1 + b1 * b2) * cosW
+                       + 2 * b0 * b2 * cos2W;
+    double denominator = a0 * a0 + a1 * a1 + a2 * a2 + 2 * (a0 * a1 + a1 * a2) * cosW
+                         + 2 * a0 * a2 * cos2W;
+    return 10 * std::log10(numerator / denominator);
+}
+
+QList<EqualizerFit::CurvePoint> PresetLibrary::loadPreset(const Entry &entry)
+{
+    QList<EqualizerFit::CurvePoint> curve;
+    QFile file(entry.filePath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return curve;
+    }
+
+    QTextStream stream(&file);
+    QString line;
+    switch (entry.format) {
+    case GraphicEq:
+        // GraphicEQ: 20 -1.2; 21 -1.3; ...
+        while (stream.readLineInto(&line)) {
+            if (!line.startsWith("GraphicEQ:")) {
+                continue;
+            }
+            const QStringList pairs = line.mid(10).split(';', Qt::SkipEmptyParts);
+            for (const QString &pair : pairs) {
+                QStringList fields = pair.split(' ', Qt::SkipEmptyParts);
+                if (fields.size() == 2) {
+                    curve.append({fields.at(0).toDouble(), fields.at(1).toDouble()});
+                }
+            }
+            break;
+        }
+        break;
+    case Parametric: {
+        // Filter 1: ON PK Fc 105 Hz Gain -2.5 dB Q 0.70
+        static const QRegularExpression filterExpression(
+            "^Filter\\s*\\d*:\\s*ON\\s+(\\w+)\\s+Fc\\s+([\\d.]+)\\s*Hz\\s+Gain\\s+([-\\d.]+)"
+            "\\s*dB(?:\\s+Q\\s+([\\d.]+))?");
+        class Filter
+        {
+        public:
+            QString type;
+            double fc;
+            double gain;
+            double q;
+        };
+        QList<Filter> filters;
+        while (stream.readLineInto(&line)) {
+            QRegularExpressionMatch match = filterExpression.match(line.trimmed());
+            if (match.hasMatch()) {
+                double q = match.captured(4).isEmpty() ? DEFAULT_Q : match.captured(4).toDouble();
+                filters.append({match.captured(1),
+                                match.captured(2).toDouble(),
+                                match.captured(3).toDouble(),
+                                q > 0 ? q : DEFAULT_Q});
+            }
+        }
+        if (filters.isEmpty()) {
+            break;
+        }
+        // Sampled a few times per band of even a 32 band equalizer
+        const int samples = 256;
+        for (int i = 0; i < samples; ++i) {
+            double frequency = 20 * std::pow(1000.0, double(i) / (samples - 1));
+            double gain = 0;
+            for (const Filter &filter : std::as_const(filters)) {
+                gain += filterResponse(filter.type, filter.fc, filter.gain, filter.q, frequency);
+            }
+            curve.append({frequency, gain});
+        }
+        break;
+    }
+    case Csv: {
+        // AutoEQ's CSVs carry several curves: the correction is the "equalization"
+        // column, the one after frequency is the raw measurement. Files with a header
+        // need that column; without one, only plain frequency,gain pairs are taken.
+        int column = -1;
+        bool header = false;
+        while (stream.readLineInto(&line)) {
+            QStringList fields = line.split(QRegularExpression("[,;\\s]+"), Qt::SkipEmptyParts);
+            if (fields.isEmpty()) {
+                continue;
+            }
+            bool frequencyOk = false;
+            double frequency = fields.at(0).toDouble(&frequencyOk);
+            if (!frequencyOk) {
+                header = true;
+                column = fields.indexOf("equalization", 0);
+                continue;
+            }
+            if (!header && column < 0) {
+                if (fields.size() != 2) {
+                    break;
+                }
+                column = 1;
+            }
+            if (column <= 0) {
+                break;
+            }
+            bool gainOk = false;
+            double gain = fields.value(column).toDouble(&gainOk);
+            if (gainOk && frequency > 0) {
+                curve.append({frequency, gain});
+            }
+        }
+        break;
+    }
+    case Unknown:
+        break;
+    }
+    return curve;
+}
@@ -0,0 +1,88 @@
+#ifndef PRESETLIBRARY_H
+#define PRESETLIBRARY_H
+
+#include "equalizerfit.h"
+
+#include <QFile>
+#include <QList>
+#include <QString>
+
+// Index over a directory tree of AutoEQ-style correction files (GraphicEQ,
+// ParametricEQ/FixedBandEQ and frequency response CSVs), searchable by
+// headphone model and preset name.
+//
+// The index lives in a single file that is memory-mapped once opened: a table
+// of entries, a table of search keys sorted by their case-folded UTF-8 bytes and
+// a string pool. A prefix search is a binary search over the mapped keys, so
+// nothing has to be loaded or parsed up front. A scan only opens files whose
+// modification time differs from the one indexed.
+//
+// build() only reads the current index, so it can run on a worker thread while
+// search() keeps answering from the old one; publish() then swaps in the new index
+// and belongs on the thread that searches. Only one build() may run at a time.
+class PresetLibrary
+{
+public:
+    enum Format : quint8 { Unknown, GraphicEq, Parametric, Csv };
+
+    class Entry
+    {
+    public:
+        QString model;
+        QString name;
+        QString filePath;
+        Format format = Unknown;
+    };
+
+    explicit PresetLibrary(const QString &indexFilePath);
+    ~PresetLibrary();
+
+    // The directory the index was built from, empty without an index
+    QString getRoot() const;
+    // Files in the index, including those in no known format
+    int size() const;
+
+    // Writes the index for root next to the current one, reusing what is indexed for
+    // unchanged files; reread is set to how many files had to be opened again
+    bool build(const QString &root, int *reread = nullptr) const;
+    // Replaces the current index with the one build() wrote
+    bool publish();
+    // build() and publish() in one go
+    bool scan(const QString &root, int *reread = nullptr);
+
+    // Entries whose model or name starts with prefix, case insensitive
+    QList<Entry> search(const QString &prefix, int limit = 200) const;
+
+    // Streams the file into the response it asks for, ready for EqualizerFit
+    static QList<EqualizerFit::CurvePoint> loadPreset(const Entry &entry);
+
+private:
+    static constexpr char MAGIC[8] = {'H', 'C', 'E', 'Q', 'I', 'D', 'X', '\0'};
+    static constexpr quint32 INDEX_VERSION = 1;
+    static constexpr int HEADER_SIZE = 32;
+    static constexpr int ENTRY_SIZE = 40;
+    static constexpr int KEY_SIZE = 12;
+
+    QFile indexFile;
+    const uchar *map = nullptr;
+    qint64 mapSize = 0;
+
+    quint32 entryCount = 0;
+    quint32 keyCount = 0;
+    qint64 poolOffset = 0;
+    QString root;
+
+    bool open();
+    void close();
+    QString builtFilePath() const;
+
+    const uchar *entryRecord(quint32 index) const;
+    const uchar *keyRecord(quint32 index) const;
+    // Reads the (offset, length) pair at record and returns that slice of the string pool
+    QByteArray stringAt(const uchar *record) const;
+    Entry entryAt(quint32 index) const;
+
+    static Format detectFormat(const QString &filePath);
+};
+
+#endif // PRESETLIBRARY_H
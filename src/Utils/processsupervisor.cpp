@@ -0,0 +1,293 @@
+#include "processsupervisor.h"
+
+#include <QDebug>
+
+#include <algorithm>
+
+ProcessJob::ProcessJob() {}
+
+ProcessJob::ProcessJob(const QStringList &args, Kind kind)
+{
+    this->args = args;
+    this->kind = kind;
+    promises.append(std::make_shared<QPromise<ProcessResult>>());
+    promises.first()->start();
+}
+
+void ProcessJob::settle(const ProcessResult &result)
+{
+    for (const auto &promise : promises) {
+        promise->addResult(result);
+        promise->finish();
+    }
+    promises.clear();
+}
+
+ProcessSupervisor::ProcessSupervisor(const QString &program, QObject *parent)
+    : QObject(parent)
+    , program(program)
+{}
+
+ProcessSupervisor::~ProcessSupervisor()
+{
+    queuedWrites.clear();
+    queuedReads.clear();
+    const QList<QProcess *> running = runningJobs.keys();
+    for (QProcess *process : running) {
+        process->kill();
+        process->waitForFinished(1000);
+    }
+}
+
+QFuture<ProcessResult> ProcessSupervisor::run(const QStringList &args, ProcessJob::Kind kind)
+{
+    ProcessJob job(args, kind);
+    QFuture<ProcessResult> future = job.promises.first()->future();
+
+    if (kind == ProcessJob::Write) {
+        cancelBackgroundRead();
+        queuedWrites.append(job);
+        startNextWrite();
+        return future;
+    }
+
+    if (!joinRead(job)) {
+        queueRead(job);
+        startNextRead();
+    }
+    return future;
+}
+
+bool ProcessSupervisor::joinRead(ProcessJob &job)
+{
+    if (readProcess != nullptr) {
+        ProcessJob &running = runningJobs[readProcess];
+        if (!running.cancelled && running.args == job.args) {
+            running.promises << job.promises;
+            mergedCount++;
+            return true;
+        }
+    }
+    for (ProcessJob &queued : queuedReads) {
+        if (queued.args == job.args) {
+            queued.promises << job.promises;
+            mergedCount++;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ProcessSupervisor::queueRead(ProcessJob job)
+{
+    // Only the newest poll is worth spawning; whoever waited on the queued
+    // one gets the newer result instead
+    if (job.kind == ProcessJob::Poll) {
+        for (auto it = queuedReads.begin(); it != queuedReads.end(); ++it) {
+            if (it->kind == ProcessJob::Poll) {
+                job.promises << it->promises;
+                queuedReads.erase(it);
+                supersededCount++;
+                break;
+            }
+        }
+    }
+
+    auto it = queuedReads.begin();
+    while (it != queuedReads.end() && it->kind <= job.kind) {
+        ++it;
+    }
+    queuedReads.insert(it, job);
+}
+
+void ProcessSupervisor::startNextWrite()
+{
+    if (writeProcess != nullptr || queuedWrites.isEmpty()) {
+        return;
+    }
+    start(queuedWrites.takeFirst());
+}
+
+void ProcessSupervisor::startNextRead()
+{
+    if (readProcess != nullptr || writeProcess != nullptr || !queuedWrites.isEmpty()
+        || queuedReads.isEmpty()) {
+        return;
+    }
+    start(queuedReads.takeFirst());
+}
+
+void ProcessSupervisor::cancelBackgroundRead()
+{
+    // A status poll only delays the write the user is waiting for; enumerations are
+    // user visible too and are left to finish
+    if (readProcess == nullptr) {
+        return;
+    }
+    ProcessJob &running = runningJobs[readProcess];
+    if (running.kind != ProcessJob::Poll || running.cancelled) {
+        return;
+    }
+    running.cancelled = true;
+    cancelledCount++;
+    // finished() follows once the child has been reaped
+    readProcess->kill();
+}
+
+void ProcessSupervisor::setTimeout(ProcessJob::Kind kind, int msec)
+{
+    if (kind == ProcessJob::Write) {
+        msecWriteTimeout = msec;
+    } else {
+        msecPollTimeout = msec;
+    }
+}
+
+int ProcessSupervisor::getTimeoutCount() const
+{
+    return timeoutCount;
+}
+
+int ProcessSupervisor::getFailureCount() const
+{
+    return failureCount;
+}
+
+int ProcessSupervisor::getSupersededCount() const
+{
+    return supersededCount;
+}
+
+int ProcessSupervisor::getMergedCount() const
+{
+    return mergedCount;
+}
+
+int ProcessSupervisor::getCancelledCount() const
+{
+    return cancelledCount;
+}
+
+QProcess *ProcessSupervisor::takeProcess()
+{
+    if (!idleProcesses.isEmpty()) {
+        return idleProcesses.takeLast();
+    }
+
+    QProcess *process = new QProcess(this);
+    QTimer *deadline = new QTimer(this);
+    deadline->setSingleShot(true);
+    deadlines.insert(process, deadline);
+
+    connect(process,
+            &QProcess::finished,
+            this,
+            [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
+                processFinished(process, exitCode, exitStatus);
+            });
+    connect(process, &QProcess::errorOccurred, this, [this, process](QProcess::ProcessError error) {
+        processError(process, error);
+    });
+    connect(deadline, &QTimer::timeout, this, [this, process]() { deadlineExpired(process); });
+
+    return process;
+}
+
+void ProcessSupervisor::start(const ProcessJob &job)
+{
+    QProcess *process = takeProcess();
+    if (job.kind == ProcessJob::Write) {
+        writeProcess = process;
+    } else {
+        readProcess = process;
+    }
+
+    runningJobs.insert(process, job);
+    deadlines.value(process)->start(job.kind == ProcessJob::Write ? msecWriteTimeout
+                                                                  : msecPollTimeout);
+
+    qDebug() << "Command: \t" << program;
+    qDebug() << "\tArgs: \theadsetcontrol " << job.args;
+    process->start(program, job.args);
+}
+
+void ProcessSupervisor::finish(QProcess *process, const ProcessResult &result)
+{
+    deadlines.value(process)->stop();
+    ProcessJob job = runningJobs.take(process);
+    idleProcesses.append(process);
+
+    if (job.kind == ProcessJob::Write) {
+        writeProcess = nullptr;
+    } else {
+        readProcess = nullptr;
+    }
+
+    if (job.cancelled) {
+        // Retried after the write, unless a newer poll queued meanwhile covers it
+        job.cancelled = false;
+        job.timedOut = false;
+        auto newer = std::find_if(queuedReads.begin(),
+                                  queuedReads.end(),
+                                  [](const ProcessJob &queued) {
+                                      return queued.kind == ProcessJob::Poll;
+                                  });
+        if (newer != queuedReads.end()) {
+            newer->promises << job.promises;
+        } else {
+            queueRead(job);
+        }
+    } else {
+        job.settle(result);
+    }
+    startNextWrite();
+    startNextRead();
+}
+
+void ProcessSupervisor::processFinished(QProcess *process,
+                                        int exitCode,
+                                        QProcess::ExitStatus exitStatus)
+{
+    if (!runningJobs.contains(process)) {
+        return;
+    }
+
+    ProcessResult result;
+    result.output = process->readAllStandardOutput();
+    process->readAllStandardError();
+    const ProcessJob &job = runningJobs[process];
+    if (job.timedOut || job.cancelled) {
+        result.output.clear();
+    } else if (exitStatus == QProcess::CrashExit) {
+        failureCount++;
+        qWarning() << "headsetcontrol crashed, exit code" << exitCode;
+    } else {
+        // headsetcontrol exits non-zero when e.g. no device is found, its output still counts
+        result.ok = true;
+    }
+    finish(process, result);
+}
+
+void ProcessSupervisor::processError(QProcess *process, QProcess::ProcessError error)
+{
+    qDebug() << "Error: \t" << error;
+    // A process that never started won't emit finished()
+    if (error == QProcess::FailedToStart && runningJobs.contains(process)) {
+        failureCount++;
+        finish(process, ProcessResult());
+    }
+}
+
+void ProcessSupervisor::deadlineExpired(QProcess *process)
+{
+    if (!runningJobs.contains(process)) {
+        return;
+    }
+
+    timeoutCount++;
+    runningJobs[process].timedOut = true;
+    qWarning() << "headsetcontrol timed out, killing it:" << runningJobs.value(process).args
+               << "(" << timeoutCount << "timeouts so far)";
+    // finished() follows once the child has been reaped
+    process->kill();
+}
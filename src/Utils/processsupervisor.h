@@ -0,0 +1,105 @@
+#ifndef PROCESSSUPERVISOR_H
+#define PROCESSSUPERVISOR_H
+
+#include <QFuture>
+#include <QHash>
+#include <QObject>
+#include <QProcess>
+#include <QPromise>
+#include <QTimer>
+
+#include <memory>
+
+// What a headsetcontrol run produced. A run that timed out, crashed or never
+// started is not ok, which tells it apart from one that printed nothing useful.
+class ProcessResult
+{
+public:
+    bool ok = false;
+    QByteArray output;
+};
+
+class ProcessJob
+{
+public:
+    // In priority order: interactive writes, then enumerations, then background status polls
+    enum Kind { Write, Enumerate, Poll };
+
+    ProcessJob();
+    ProcessJob(const QStringList &args, Kind kind);
+
+    QStringList args;
+    Kind kind = Poll;
+    bool timedOut = false;
+    // Killed to make way for a write, it gets queued again instead of settled
+    bool cancelled = false;
+    // Merged and superseded requests hand their promises over to the job that runs
+    QList<std::shared_ptr<QPromise<ProcessResult>>> promises;
+
+    void settle(const ProcessResult &result);
+};
+
+// Runs headsetcontrol invocations on a pool of reusable QProcess objects.
+// Every run has a deadline after which the child is killed and reaped.
+//
+// Writes run one at a time, in the order they were requested, and go before
+// any queued read. Reads (enumerations and polls) run one at a time too,
+// never alongside a write, and in priority order. A read identical to one
+// already running or queued joins it instead of spawning another child, a
+// newer poll replaces a queued one, and a background poll still running when
+// a write arrives is killed and retried once the write is done.
+class ProcessSupervisor : public QObject
+{
+    Q_OBJECT
+
+public:
+    ProcessSupervisor(const QString &program, QObject *parent = nullptr);
+    ~ProcessSupervisor();
+
+    QFuture<ProcessResult> run(const QStringList &args, ProcessJob::Kind kind);
+
+    void setTimeout(ProcessJob::Kind kind, int msec);
+
+    int getTimeoutCount() const;
+    int getFailureCount() const;
+    int getSupersededCount() const;
+    int getMergedCount() const;
+    int getCancelledCount() const;
+
+private:
+    QString program;
+
+    int msecPollTimeout = 5000;
+    int msecWriteTimeout = 15000;
+
+    QList<QProcess *> idleProcesses;
+    QHash<QProcess *, ProcessJob> runningJobs;
+    QHash<QProcess *, QTimer *> deadlines;
+
+    // headsetcontrol opens the device for every write, two at once would fight over it
+    QProcess *writeProcess = nullptr;
+    QList<ProcessJob> queuedWrites;
+    QProcess *readProcess = nullptr;
+    // Sorted by kind, first come first served within one
+    QList<ProcessJob> queuedReads;
+
+    int timeoutCount = 0;
+    int failureCount = 0;
+    int supersededCount = 0;
+    int mergedCount = 0;
+    int cancelledCount = 0;
+
+    QProcess *takeProcess();
+    bool joinRead(ProcessJob &job);
+    void queueRead(ProcessJob job);
+    void startNextWrite();
+    void startNextRead();
+    void cancelBackgroundRead();
+    void start(const ProcessJob &job);
+    void finish(QProcess *process, const ProcessResult &result);
+    void processFinished(QProcess *process, int exitCode, QProcess::ExitStatus exitStatus);
+    void processError(QProcess *process, QProcess::ProcessError error);
+    void deadlineExpired(QProcess *process);
+};
+
+#endif // PROCESSSUPERVISOR_H
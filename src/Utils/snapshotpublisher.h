@@ -0,0 +1,71 @@
+#ifndef SNAPSHOTPUBLISHER_H
+#define SNAPSHOTPUBLISHER_H
+
+#include <array>
+#include <atomic>
+#include <memory>
+
+// Holds the latest immutable snapshot of some state. One thread publishes whole
+// new snapshots, any thread reads them. A reader keeps the snapshot it loaded alive
+// for as long as it holds it, so it always sees a consistent view; the last holder
+// frees it.
+//
+// Neither side takes a lock: the snapshots sit in a few slots and an atomic index
+// names the current one. A reader pins the slot while it copies the shared_ptr out,
+// and the publisher only ever writes a slot that is neither current nor pinned.
+// (The shared_ptr overloads of std::atomic_load/atomic_store would do, but
+// libstdc++ and MSVC implement them with a shared pool of locks.)
+template<typename T>
+class SnapshotPublisher
+{
+public:
+    SnapshotPublisher() { slots[0] = std::make_shared<const T>(); }
+
+    std::shared_ptr<const T> load() const
+    {
+        while (true) {
+            int slot = current.load();
+            pins[slot].fetch_add(1);
+            // Still current after pinning, so the publisher can't be writing it
+            if (current.load() == slot) {
+                std::shared_ptr<const T> snapshot = slots[slot];
+                pins[slot].fetch_sub(1);
+                return snapshot;
+            }
+            pins[slot].fetch_sub(1);
+        }
+    }
+
+    // Must only be called from one thread at a time
+    void publish(std::shared_ptr<const T> snapshot)
+    {
+        const int slot = current.load();
+        int next = slot;
+        // A pin only lasts for a shared_ptr copy, so a free slot turns up right away
+        do {
+            next = (next + 1) % SLOTS;
+        } while (next == slot || pins[next].load() != 0);
+
+        slots[next] = std::move(snapshot);
+        current.store(next);
+        // Same rule for letting go of the old one, unless a reader is copying it
+        if (pins[slot].load() == 0) {
+            slots[slot].reset();
+        }
+    }
+
+    void publish(T snapshot) { publish(std::make_shared<const T>(std::move(snapshot))); }
+
+    // Whether the index and pins are real atomics on this platform, not emulated with a lock
+    bool isLockFree() const { return current.is_lock_free() && pins[0].is_lock_free(); }
+
+private:
+    static constexpr int SLOTS = 4;
+
+    std::array<std::shared_ptr<const T>, SLOTS> slots;
+    std::atomic<int> current{0};
+    // Readers copying out of each slot right now
+    mutable std::array<std::atomic<int>, SLOTS> pins{};
+};
+
+#endif // SNAPSHOTPUBLISHER_H
@@ -0,0 +1,53 @@
+#include "startuptimeline.h"
+
+#include <QDebug>
+
+StartupTimeline::StartupTimeline()
+{
+    clock.start();
+}
+
+StartupTimeline &StartupTimeline::instance()
+{
+    static StartupTimeline timeline;
+    return timeline;
+}
+
+void StartupTimeline::setEnabled(bool enabled)
+{
+    this->enabled = enabled;
+}
+
+void StartupTimeline::mark(const QString &stage)
+{
+    if (finished) {
+        return;
+    }
+    stages.append({stage, clock.elapsed()});
+}
+
+void StartupTimeline::finish(const QString &stage)
+{
+    if (finished) {
+        return;
+    }
+    mark(stage);
+    finished = true;
+    if (enabled) {
+        print();
+    }
+    stages.clear();
+}
+
+void StartupTimeline::print() const
+{
+    qInfo().noquote() << "Startup timeline:";
+    qint64 msecStart = 0;
+    for (const Stage &stage : stages) {
+        qInfo().noquote() << QString("  %1 ms\t+%2 ms\t%3")
+                                 .arg(stage.msecEnd, 6)
+                                 .arg(stage.msecEnd - msecStart, 5)
+                                 .arg(stage.name);
+        msecStart = stage.msecEnd;
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef STARTUPTIMELINE_H
+#define STARTUPTIMELINE_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QString>
+
+// Records how long each startup stage took, measured from process start up to
+// the first device update. Printed once at the end when enabled from the
+// command line (--startup-timeline).
+class StartupTimeline
+{
+public:
+    static StartupTimeline &instance();
+
+    void setEnabled(bool enabled);
+
+    // Ends the stage running since the previous mark
+    void mark(const QString &stage);
+    // Marks the last stage and prints the timeline; later calls do nothing
+    void finish(const QString &stage);
+
+private:
+    StartupTimeline();
+
+    class Stage
+    {
+    public:
+        QString name;
+        qint64 msecEnd;
+    };
+
+    QElapsedTimer clock;
+    QList<Stage> stages;
+    bool enabled = false;
+    bool finished = false;
+
+    void print() const;
+};
+
+#endif // STARTUPTIMELINE_H
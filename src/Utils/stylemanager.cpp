@@ -0,0 +1,91 @@
+#include "stylemanager.h"
+
+#include <QDir>
+#include <QFile>
+
+const QString StyleManager::DEFAULT_STYLE = "Default";
+
+StyleManager::StyleManager(const QString &stylesPath, QObject *parent)
+    : QObject(parent)
+    , stylesPath(stylesPath)
+    , watcher(this)
+{
+    connect(&watcher, &QFileSystemWatcher::directoryChanged, this, &StyleManager::refresh);
+    connect(&watcher, &QFileSystemWatcher::fileChanged, this, &StyleManager::reloadActive);
+
+    QDir().mkpath(stylesPath);
+    watcher.addPath(stylesPath);
+    scanDirectory();
+}
+
+QString StyleManager::getStylesPath() const
+{
+    return stylesPath;
+}
+
+QStringList StyleManager::styles() const
+{
+    return names;
+}
+
+QString StyleManager::activeStyle() const
+{
+    return active;
+}
+
+void StyleManager::setActiveStyle(const QString &name)
+{
+    if (name == active) {
+        return;
+    }
+    if (active != DEFAULT_STYLE) {
+        watcher.removePath(activeFilePath());
+    }
+    active = name;
+    reloadActive();
+}
+
+QString StyleManager::styleSheet() const
+{
+    return contents;
+}
+
+void StyleManager::refresh()
+{
+    scanDirectory();
+    // Editors often save by replacing the file, which drops it from the watcher
+    reloadActive();
+}
+
+QString StyleManager::activeFilePath() const
+{
+    return stylesPath + "/" + active;
+}
+
+void StyleManager::scanDirectory()
+{
+    QStringList list = QDir(stylesPath).entryList(QStringList() << "*.qss", QDir::Files);
+    if (list != names) {
+        names = list;
+        emit stylesChanged();
+    }
+}
+
+void StyleManager::reloadActive()
+{
+    QString styleSheet;
+    if (active != DEFAULT_STYLE) {
+        QFile file(activeFilePath());
+        if (file.open(QFile::ReadOnly)) {
+            styleSheet = QString::fromUtf8(file.readAll());
+            if (!watcher.files().contains(file.fileName())) {
+                watcher.addPath(file.fileName());
+            }
+        }
+    }
+
+    if (styleSheet != contents) {
+        contents = styleSheet;
+        emit styleSheetChanged(contents);
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef STYLEMANAGER_H
+#define STYLEMANAGER_H
+
+#include <QFileSystemWatcher>
+#include <QObject>
+#include <QStringList>
+
+// Keeps the list of .qss files in the styles directory and the contents of the
+// active one in memory, watching both for changes. styleSheetChanged() is only
+// emitted when the active stylesheet's text actually changes, so callers can
+// re-polish their widgets on it without doing so needlessly.
+class StyleManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Name of the built-in style, which has no file
+    static const QString DEFAULT_STYLE;
+
+    explicit StyleManager(const QString &stylesPath, QObject *parent = nullptr);
+
+    QString getStylesPath() const;
+    // File names of the available styles, without DEFAULT_STYLE
+    QStringList styles() const;
+
+    QString activeStyle() const;
+    void setActiveStyle(const QString &name);
+    // Contents of the active style, empty for DEFAULT_STYLE or a missing file
+    QString styleSheet() const;
+
+    // Rescans right away, e.g. after copying a style in
+    void refresh();
+
+signals:
+    void stylesChanged();
+    void styleSheetChanged(const QString &styleSheet);
+
+private:
+    QString stylesPath;
+    QFileSystemWatcher watcher;
+
+    QStringList names;
+    QString active = DEFAULT_STYLE;
+    QString contents;
+
+    QString activeFilePath() const;
+    void scanDirectory();
+    void reloadActive();
+};
+
+#endif // STYLEMANAGER_H
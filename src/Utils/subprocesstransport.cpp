@@ -0,0 +1,145 @@
+#include "subprocesstransport.h"
+
+#include <QFileInfo>
+
+SubprocessTransport::SubprocessTransport(const QString &headsetcontrolFilePath, QObject *parent)
+    : HeadsetTransport(parent)
+    , headsetcontrolFilePath(headsetcontrolFilePath)
+    , supervisor(headsetcontrolFilePath, this)
+    , stream(headsetcontrolFilePath, this)
+{
+    connect(&stream,
+            &HeadsetControlStream::documentReceived,
+            this,
+            [this](const QByteArray &output) { emit statusUpdated(parseStatus(output)); });
+}
+
+bool SubprocessTransport::isAvailable() const
+{
+    return QFileInfo::exists(headsetcontrolFilePath);
+}
+
+QFuture<QList<Device>> SubprocessTransport::enumerate()
+{
+    return sendCommand(QStringList(), ProcessJob::Enumerate)
+        .then(this, [this](const ProcessResult &result) {
+            // A run that timed out or crashed says nothing about what is attached
+            if (!result.ok) {
+                qDebug() << "headsetcontrol failed, keeping the" << lastOutput.devices.length()
+                         << "known devices";
+                return lastOutput.devices;
+            }
+            parseDevices(result.output);
+            return lastOutput.devices;
+        });
+}
+
+QFuture<QList<DeviceStatus>> SubprocessTransport::status()
+{
+    return sendCommand(statusArguments()).then(this, [this](const ProcessResult &result) {
+        if (!result.ok) {
+            return lastStatuses;
+        }
+        lastStatuses = parseStatus(result.output);
+        return lastStatuses;
+    });
+}
+
+QFuture<QList<Action>> SubprocessTransport::apply(const QList<Command> &commands)
+{
+    QStringList args;
+    for (const Command &command : commands) {
+        args << command.flag << command.argument;
+    }
+
+    return sendCommand(args, ProcessJob::Write).then(this, [this](const ProcessResult &result) {
+        HeadsetControlOutput parsed;
+        if (!result.ok) {
+            qDebug() << "headsetcontrol failed, no command was confirmed";
+            return parsed.actions;
+        }
+        HeadsetControlParser(&metadataCache).parse(result.output, parsed);
+
+        for (const Action &action : std::as_const(parsed.actions)) {
+            qDebug() << "Device:\t" << action.device;
+            qDebug() << "Capability:" << action.capability;
+            qDebug() << "Status:\t" << action.status;
+            if (!action.success) {
+                qDebug() << "Error:\t" << action.error_message;
+            }
+        }
+
+        return parsed.actions;
+    });
+}
+
+void SubprocessTransport::startFollowing(int secondsInterval)
+{
+    stream.start(secondsInterval, statusArguments());
+}
+
+void SubprocessTransport::stopFollowing()
+{
+    stream.stop();
+}
+
+bool SubprocessTransport::isFollowing() const
+{
+    return stream.isRunning();
+}
+
+void SubprocessTransport::parseDevices(const QByteArray &output)
+{
+    if (!HeadsetControlParser(&metadataCache).parse(output, lastOutput)) {
+        qDebug() << "Unable to parse headsetcontrol output";
+        return;
+    }
+
+    name = lastOutput.name;
+    version = QVersionNumber::fromString(lastOutput.version);
+    api_version = QVersionNumber::fromString(lastOutput.api_version);
+    hidapi_version = QVersionNumber::fromString(lastOutput.hidapi_version);
+
+    qDebug() << "Found" << lastOutput.devices.length() << "devices:";
+    for (const Device &device : std::as_const(lastOutput.devices)) {
+        qDebug() << "\t" << device.device;
+    }
+}
+
+QList<DeviceStatus> SubprocessTransport::parseStatus(const QByteArray &output)
+{
+    QList<DeviceStatus> statuses;
+    if (!HeadsetControlParser().parseStatus(output, statuses)) {
+        qDebug() << "Unable to parse headsetcontrol status";
+    }
+    return statuses;
+}
+
+QStringList SubprocessTransport::statusArguments() const
+{
+    // Only ask for what the attached devices support, headsetcontrol errors out otherwise.
+    // The metadata cache also remembers devices unplugged since, so it can't tell.
+    QSet<QString> capabilities;
+    for (const Device &device : std::as_const(lastOutput.devices)) {
+        capabilities.unite(device.capabilities);
+    }
+    QStringList args;
+    if (capabilities.contains("CAP_BATTERY_STATUS")) {
+        args << QString("--battery");
+    }
+    if (capabilities.contains("CAP_CHATMIX_STATUS")) {
+        args << QString("--chatmix");
+    }
+    return args;
+}
+
+// HC rleated functions
+QFuture<ProcessResult> SubprocessTransport::sendCommand(const QStringList &args_list,
+                                                        ProcessJob::Kind kind)
+{
+    QStringList args = QStringList() << QString("--output") << QString("JSON");
+    //args << QString("--test-device"); //Uncomment this to enable all "modules"
+    args << args_list;
+
+    return supervisor.run(args, kind);
+}
@@ -0,0 +1,47 @@
+#ifndef SUBPROCESSTRANSPORT_H
+#define SUBPROCESSTRANSPORT_H
+
+#include "devicemetadatacache.h"
+#include "headsetcontrolparser.h"
+#include "headsetcontrolstream.h"
+#include "headsettransport.h"
+#include "processsupervisor.h"
+
+// Talks to the hardware by running the external headsetcontrol binary
+class SubprocessTransport : public HeadsetTransport
+{
+    Q_OBJECT
+
+public:
+    SubprocessTransport(const QString &headsetcontrolFilePath, QObject *parent = nullptr);
+
+    bool isAvailable() const override;
+
+    QFuture<QList<Device>> enumerate() override;
+    QFuture<QList<DeviceStatus>> status() override;
+    QFuture<QList<Action>> apply(const QList<Command> &commands) override;
+
+    void startFollowing(int secondsInterval) override;
+    void stopFollowing() override;
+    bool isFollowing() const override;
+
+private:
+    QString headsetcontrolFilePath;
+
+    // Parented to the transport so they follow it to the API thread
+    ProcessSupervisor supervisor;
+    HeadsetControlStream stream;
+    DeviceMetadataCache metadataCache;
+    // Last successful results, returned again when a run fails. Every enumeration is
+    // parsed into the same output, so known devices are overwritten in place.
+    HeadsetControlOutput lastOutput;
+    QList<DeviceStatus> lastStatuses;
+
+    void parseDevices(const QByteArray &output);
+    QList<DeviceStatus> parseStatus(const QByteArray &output);
+    QStringList statusArguments() const;
+    QFuture<ProcessResult> sendCommand(const QStringList &args_list,
+                                       ProcessJob::Kind kind = ProcessJob::Poll);
+};
+
+#endif // SUBPROCESSTRANSPORT_H
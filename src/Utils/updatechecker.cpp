@@ -0,0 +1,124 @@
+#include "updatechecker.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkReply>
+#include <QPromise>
+#include <QSaveFile>
+
+#include <memory>
+
+UpdateChecker::UpdateChecker(const QString &cacheFilePath, const QUrl &apiUrl, QObject *parent)
+    : QObject(parent)
+    , cacheFilePath(cacheFilePath)
+    , apiUrl(apiUrl)
+    , manager(this)
+{
+    loadCache();
+}
+
+QUrl UpdateChecker::defaultApiUrl()
+{
+    QString url = qEnvironmentVariable("HEADSETCONTROL_GUI_RELEASES_API");
+    return QUrl(url.isEmpty() ? QString("https://api.github.com") : url);
+}
+
+void UpdateChecker::setTtl(int secs)
+{
+    secsTtl = qMax(0, secs);
+}
+
+QFuture<QString> UpdateChecker::latestVersion(const QString &owner, const QString &repo)
+{
+    const QString key = owner + "/" + repo;
+    const qint64 now = QDateTime::currentSecsSinceEpoch();
+
+    if (cache.contains(key) && now - cache.value(key).checked < secsTtl) {
+        return QtFuture::makeReadyValueFuture(cache.value(key).version);
+    }
+
+    QUrl url = apiUrl;
+    url.setPath(url.path() + QString("/repos/%1/%2/releases/latest").arg(owner, repo));
+    QNetworkRequest request(url);
+    request.setHeader(QNetworkRequest::UserAgentHeader, "Mozilla/5.0");
+    request.setTransferTimeout(MSEC_REQUEST_TIMEOUT);
+    if (cache.contains(key) && !cache.value(key).etag.isEmpty()) {
+        request.setRawHeader("If-None-Match", cache.value(key).etag);
+    }
+
+    auto promise = std::make_shared<QPromise<QString>>();
+    promise->start();
+    QNetworkReply *reply = manager.get(request);
+    connect(reply, &QNetworkReply::finished, this, [this, reply, promise, key, now]() {
+        int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        CacheEntry entry = cache.value(key);
+
+        if (reply->error() == QNetworkReply::NoError && statusCode == 304) {
+            entry.checked = now;
+        } else if (reply->error() == QNetworkReply::NoError) {
+            QJsonDocument doc = QJsonDocument::fromJson(reply->readAll());
+            QString version = doc.object().value("tag_name").toString();
+            if (version.startsWith('v')) {
+                version.removeFirst();
+            }
+            entry.version = version;
+            entry.etag = reply->rawHeader("ETag");
+            entry.checked = now;
+        } else {
+            // Keep the stale answer: it is still the best one we have
+            qDebug() << "Update check failed:" << reply->errorString();
+        }
+        reply->deleteLater();
+
+        if (entry.checked == now) {
+            cache.insert(key, entry);
+            saveCache();
+        }
+        promise->addResult(entry.version);
+        promise->finish();
+    });
+
+    return promise->future();
+}
+
+void UpdateChecker::loadCache()
+{
+    QFile file(cacheFilePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    QJsonObject json = QJsonDocument::fromJson(file.readAll()).object();
+    for (auto it = json.constBegin(); it != json.constEnd(); ++it) {
+        QJsonObject object = it.value().toObject();
+        CacheEntry entry;
+        entry.version = object["version"].toString();
+        entry.etag = object["etag"].toString().toUtf8();
+        entry.checked = object["checked"].toInteger();
+        cache.insert(it.key(), entry);
+    }
+}
+
+void UpdateChecker::saveCache() const
+{
+    QJsonObject json;
+    for (auto it = cache.constBegin(); it != cache.constEnd(); ++it) {
+        QJsonObject object;
+        object["version"] = it.value().version;
+        object["etag"] = QString::fromUtf8(it.value().etag);
+        object["checked"] = it.value().checked;
+        json[it.key()] = object;
+    }
+
+    QSaveFile file(cacheFilePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Couldn't open" << cacheFilePath << "for writing";
+        return;
+    }
+    file.write(QJsonDocument(json).toJson());
+    if (!file.commit()) {
+        qWarning() << "Couldn't save" << cacheFilePath;
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef UPDATECHECKER_H
+#define UPDATECHECKER_H
+
+#include <QFuture>
+#include <QHash>
+#include <QNetworkAccessManager>
+#include <QObject>
+#include <QUrl>
+
+// Looks up the latest GitHub release of a repository without blocking the
+// caller. Answers are cached on disk: within the TTL no request is made at all,
+// after it the request carries the cached ETag so an unchanged release costs a
+// 304 and no rate limit. When offline the last known version is returned.
+class UpdateChecker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit UpdateChecker(const QString &cacheFilePath,
+                           const QUrl &apiUrl = defaultApiUrl(),
+                           QObject *parent = nullptr);
+
+    // Resolves to the release version without its leading "v", or an empty string
+    QFuture<QString> latestVersion(const QString &owner, const QString &repo);
+
+    void setTtl(int secs);
+
+    // HEADSETCONTROL_GUI_RELEASES_API overrides https://api.github.com, e.g. with a local server
+    static QUrl defaultApiUrl();
+
+private:
+    static constexpr int SECS_DEFAULT_TTL = 6 * 60 * 60;
+    static constexpr int MSEC_REQUEST_TIMEOUT = 10000;
+
+    class CacheEntry
+    {
+    public:
+        QString version;
+        QByteArray etag;
+        qint64 checked = 0;
+    };
+
+    QString cacheFilePath;
+    QUrl apiUrl;
+    int secsTtl = SECS_DEFAULT_TTL;
+
+    QNetworkAccessManager manager;
+    QHash<QString, CacheEntry> cache;
+
+    void loadCache();
+    void saveCache() const;
+};
+
+#endif // UPDATECHECKER_H
@@ -1,39 +1,13 @@
 #include "utils.h"
 
 #include <QCoreApplication>
+#include <QDebug>
 #include <QDesktopServices>
 #include <QDir>
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QNetworkReply>
+#include <QFileInfo>
 #include <QProcess>
 #include <QStandardPaths>
 
-QString getLatestGitHubReleaseVersion(const QString &owner, const QString &repo)
-{
-    QEventLoop loop;
-    QNetworkAccessManager manager;
-    QNetworkRequest request(
-        QUrl(QString("https://api.github.com/repos/%1/%2/releases/latest").arg(owner, repo)));
-    request.setHeader(QNetworkRequest::UserAgentHeader, "Mozilla/5.0");
-
-    QNetworkReply *reply = manager.get(request);
-    QObject::connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
-    loop.exec();
-
-    if (reply->error() == QNetworkReply::NoError) {
-        QJsonDocument doc = QJsonDocument::fromJson(reply->readAll());
-        QJsonObject jsonObj = doc.object();
-        QString latestVersion = jsonObj.value("tag_name").toString();
-        reply->deleteLater();
-        return latestVersion.removeFirst();
-    } else {
-        qDebug() << "Error:" << reply->errorString();
-        reply->deleteLater();
-        return QString();
-    }
-}
-
 bool fileExists(const QString &filePath)
 {
     QFileInfo checkFile(filePath);
@@ -102,6 +76,9 @@ bool createStartMenuShortcut()
 #ifdef Q_OS_WIN
     QString startupPath = QStandardPaths::writableLocation(QStandardPaths::ApplicationsLocation);
     QString linkPath = startupPath + QDir::separator() + appName + ".lnk";
+    if (QFileInfo(linkPath).symLinkTarget() == QFileInfo(appPath).absoluteFilePath()) {
+        return true;
+    }
     QFile::remove(linkPath);
     return QFile::link(appPath, linkPath);
 
@@ -112,15 +89,6 @@ bool createStartMenuShortcut()
     // Create applications directory if it doesn't exist
     QDir().mkpath(applicationsDir);
 
-    // Create .desktop file
-    QString desktopFilePath = applicationsDir + appName.toLower() + ".desktop";
-    QFile desktopFile(desktopFilePath);
-
-    if (!desktopFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        qDebug() << "Failed to create .desktop file";
-        return false;
-    }
-
     // Desktop entry content
     QString desktopContent = QString("[Desktop Entry]\n"
                                      "Version=1.0\n"
@@ -130,6 +98,22 @@ bool createStartMenuShortcut()
                                      "Terminal=false\n"
                                      "Categories=Utility;\n")
                                  .arg(appName, appPath);
+
+    // Create .desktop file, unless an identical one is already there
+    QString desktopFilePath = applicationsDir + appName.toLower() + ".desktop";
+    QFile desktopFile(desktopFilePath);
+    if (desktopFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        bool upToDate = desktopFile.readAll() == desktopContent.toUtf8();
+        desktopFile.close();
+        if (upToDate) {
+            return true;
+        }
+    }
+
+    if (!desktopFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qDebug() << "Failed to create .desktop file";
+        return false;
+    }
     desktopFile.write(desktopContent.toUtf8());
     desktopFile.close();
 
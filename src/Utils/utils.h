@@ -3,8 +3,6 @@
 
 #include <QString>
 
-QString getLatestGitHubReleaseVersion(const QString &owner, const QString &repo);
-
 bool fileExists(const QString &filepath);
 
 bool openFileExplorer(const QString &path);
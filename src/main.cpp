@@ -1,6 +1,9 @@
 #include "mainwindow.h"
+#include "startuptimeline.h"
 
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QDebug>
 #include <QTranslator>
 
 const QString APP_NAME = "HeadsetControl-GUI";
@@ -8,15 +11,40 @@ const QString GUI_VERSION = "0.17.0";
 
 int main(int argc, char *argv[])
 {
+    // Starts the clock
+    StartupTimeline &timeline = StartupTimeline::instance();
+
     QApplication app(argc, argv);
     app.setApplicationName(APP_NAME);
     app.setApplicationVersion(GUI_VERSION);
+
+    QCommandLineParser parser;
+    QCommandLineOption helpOption = parser.addHelpOption();
+    QCommandLineOption versionOption = parser.addVersionOption();
+    QCommandLineOption timelineOption("startup-timeline",
+                                      "Print how long each startup stage took.");
+    parser.addOption(timelineOption);
+    // Unlike process(), doesn't exit on options it doesn't know, e.g. from a newer version
+    if (!parser.parse(QCoreApplication::arguments())) {
+        qDebug() << "Ignoring command line:" << parser.errorText();
+    }
+    if (parser.isSet(helpOption)) {
+        parser.showHelp();
+    }
+    if (parser.isSet(versionOption)) {
+        parser.showVersion();
+    }
+    timeline.setEnabled(parser.isSet(timelineOption));
+    timeline.mark("application");
+
     QLocale locale = QLocale::system();
     QString languageCode = locale.name();
     QTranslator translator;
     if (translator.load(":/translations/tr/HeadsetControl_GUI_" + languageCode + ".qm")) {
         app.installTranslator(&translator);
     }
+    timeline.mark("translations");
+
     MainWindow window;
 
     return app.exec();
@@ -0,0 +1,11 @@
+include(../tests.pri)
+include(../headsetcontrolapi.pri)
+
+# Built with ThreadSanitizer: any unsynchronized access between the GUI thread
+# and the API thread fails the run
+CONFIG += sanitizer sanitize_thread
+
+TARGET = tst_apithread
+
+SOURCES += \
+    tst_apithread.cpp
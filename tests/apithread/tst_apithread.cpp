@@ -0,0 +1,189 @@
+#include "faketransport.h"
+#include "headsetcontrolapi.h"
+
+#include <QTest>
+#include <QThread>
+
+#include <atomic>
+#include <memory>
+
+// Runs HeadsetControlAPI on its own thread as MainWindow does, calls it from the test's
+// thread the way the GUI does, and keeps a third thread reading getState() meanwhile
+class TestApiThread : public QObject
+{
+    Q_OBJECT
+
+private:
+    QThread apiThread;
+    FakeTransport *transport = nullptr;
+    HeadsetControlAPI *api = nullptr;
+
+    std::unique_ptr<QThread> reader;
+    std::atomic<bool> reading{false};
+    std::atomic<bool> consistentReads{true};
+
+    void startReader();
+    void stopReader();
+
+    // Runs call on the API thread and waits for it, the only safe way to look at the transport
+    template<typename Function>
+    void onApiThread(Function call)
+    {
+        QMetaObject::invokeMethod(api, call, Qt::BlockingQueuedConnection);
+    }
+
+private slots:
+    void init();
+    void cleanup();
+
+    void appliesSettersFromGuiThread();
+    void sendsBatchFromGuiThread();
+    void publishesStatusToGuiThread();
+};
+
+void TestApiThread::init()
+{
+    transport = new FakeTransport();
+    // Takes ownership of the transport
+    api = new HeadsetControlAPI(transport);
+
+    apiThread.setObjectName("HeadsetControlAPI");
+    api->moveToThread(&apiThread);
+    connect(&apiThread, &QThread::finished, api, &QObject::deleteLater);
+    apiThread.start();
+
+    startReader();
+}
+
+void TestApiThread::cleanup()
+{
+    stopReader();
+    apiThread.quit();
+    apiThread.wait();
+    api = nullptr;
+    transport = nullptr;
+
+    // Results still queued to this thread would reach handlers of a test that has returned
+    QCoreApplication::removePostedEvents(this, QEvent::MetaCall);
+}
+
+void TestApiThread::startReader()
+{
+    reading = true;
+    consistentReads = true;
+    reader.reset(QThread::create([this]() {
+        quint64 lastSequence = 0;
+        while (reading) {
+            std::shared_ptr<const DeviceState> state = api->getState();
+            // A snapshot never goes back in time and is never seen half written
+            if (state->sequence < lastSequence
+                || (state->sequence > 0 && state->statuses.size() != 1)) {
+                consistentReads = false;
+            }
+            lastSequence = state->sequence;
+        }
+    }));
+    reader->setObjectName("StateReader");
+    reader->start();
+}
+
+void TestApiThread::stopReader()
+{
+    if (!reader) {
+        return;
+    }
+    reading = false;
+    reader->wait();
+    reader.reset();
+}
+
+void TestApiThread::appliesSettersFromGuiThread()
+{
+    QHash<QString, int> lastApplied;
+    connect(api,
+            &HeadsetControlAPI::settingApplied,
+            this,
+            [&](const QString &capability, const QVariant &value) {
+                lastApplied.insert(capability, value.toInt());
+            });
+
+    // Far more calls than the batch window and the command interval let through
+    for (int level = 0; level < 200; ++level) {
+        api->setSidetone(level);
+        api->setMicrophoneVolume(level);
+    }
+    QTRY_COMPARE(lastApplied.value("CAP_SIDETONE", -1), 199);
+    QTRY_COMPARE(lastApplied.value("CAP_MICROPHONE_VOLUME", -1), 199);
+
+    int sidetone = -1;
+    qsizetype commandCount = 0;
+    onApiThread([&]() {
+        sidetone = transport->devices.first().sidetone;
+        commandCount = transport->appliedCommands.size();
+    });
+    QCOMPARE(sidetone, 199);
+    QVERIFY(commandCount < 400);
+}
+
+void TestApiThread::sendsBatchFromGuiThread()
+{
+    int successes = 0;
+    connect(api, &HeadsetControlAPI::actionSuccesful, this, [&]() { successes++; });
+
+    api->beginBatch();
+    api->setLights(true);
+    api->setInactiveTime(15);
+    api->setEqualizerPreset(2);
+    api->commitBatch();
+    QTRY_COMPARE(successes, 1);
+
+    // One actionSuccesful() per apply(), so all three went out together
+    QList<Command> applied;
+    onApiThread([&]() { applied = transport->appliedCommands; });
+    QCOMPARE(applied.size(), 3);
+}
+
+void TestApiThread::publishesStatusToGuiThread()
+{
+    int updates = 0;
+    bool onGuiThread = true;
+    qsizetype statusCount = 0;
+    connect(api,
+            &HeadsetControlAPI::statusUpdated,
+            this,
+            [&](const QList<DeviceStatus> &statuses) {
+                onGuiThread = onGuiThread && QThread::currentThread() == thread();
+                statusCount = statuses.size();
+                updates++;
+            });
+    QHash<QString, int> lastApplied;
+    connect(api,
+            &HeadsetControlAPI::settingApplied,
+            this,
+            [&](const QString &capability, const QVariant &value) {
+                lastApplied.insert(capability, value.toInt());
+            });
+
+    // Polls and setters interleaved, as while the user drags a slider
+    QList<QFuture<QList<DeviceStatus>>> polls;
+    for (int i = 0; i < 50; ++i) {
+        polls.append(api->getStatus());
+        api->setSidetone(i);
+    }
+    QTRY_COMPARE(updates, 50);
+    QTRY_COMPARE(lastApplied.value("CAP_SIDETONE", -1), 49);
+
+    QVERIFY(onGuiThread);
+    QCOMPARE(statusCount, 1);
+    for (const QFuture<QList<DeviceStatus>> &poll : std::as_const(polls)) {
+        QVERIFY(poll.isFinished());
+        QCOMPARE(poll.result().size(), 1);
+    }
+    QCOMPARE(api->getState()->sequence, quint64(50));
+
+    stopReader();
+    QVERIFY(consistentReads);
+}
+
+QTEST_GUILESS_MAIN(TestApiThread)
+#include "tst_apithread.moc"
@@ -0,0 +1,10 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <QtGlobal>
+
+// Heap allocations made so far by the test binary that links allocationcounter.cpp.
+// Compare two readings around the code under test.
+quint64 allocationCount();
+
+#endif // ALLOCATIONCOUNTER_H
@@ -0,0 +1,8 @@
+# Counts the heap allocations of the whole test binary, see allocationcounter.h
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    $$PWD/allocationcounter.cpp
+
+HEADERS += \
+    $$PWD/allocationcounter.h
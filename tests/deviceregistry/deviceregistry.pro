@@ -0,0 +1,14 @@
+include(../tests.pri)
+
+TARGET = tst_deviceregistry
+
+SOURCES += \
+    $$SRC_DIR/DataTypes/configfile.cpp \
+    $$SRC_DIR/DataTypes/device.cpp \
+    $$SRC_DIR/DataTypes/deviceregistry.cpp \
+    tst_deviceregistry.cpp
+
+HEADERS += \
+    $$SRC_DIR/DataTypes/configfile.h \
+    $$SRC_DIR/DataTypes/device.h \
+    $$SRC_DIR/DataTypes/deviceregistry.h
@@ -0,0 +1,133 @@
+#include "deviceregistry.h"
+
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+
+static Device createDevice(const QString &id_vendor, const QString &id_product)
+{
+    Device device;
+    device.id_vendor = id_vendor;
+    device.id_product = id_product;
+    return device;
+}
+
+class TestDeviceRegistry : public QObject
+{
+    Q_OBJECT
+
+private:
+    QTemporaryDir sysfs;
+
+    void addNode(const QString &node, const QByteArray &uevent);
+
+private slots:
+    void initTestCase();
+
+    void readsPhysicalUnits();
+    void namesUnitsAfterPhysicalUnits();
+    void fallsBackToPosition();
+    void keepsAssignedIds();
+    void findsByKey();
+};
+
+void TestDeviceRegistry::addNode(const QString &node, const QByteArray &uevent)
+{
+    QVERIFY(QDir(sysfs.path()).mkpath(node + "/device"));
+    QFile file(sysfs.filePath(node + "/device/uevent"));
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(uevent);
+}
+
+void TestDeviceRegistry::initTestCase()
+{
+    QVERIFY(sysfs.isValid());
+    // Two identical Arctis Nova 7 dongles, each with two interfaces, and a serial-bearing headset
+    addNode("hidraw0",
+            "HID_ID=0003:00001038:00002202\nHID_NAME=SteelSeries Arctis Nova 7\n"
+            "HID_PHYS=usb-0000:00:14.0-2/input3\nHID_UNIQ=\n");
+    addNode("hidraw1",
+            "HID_ID=0003:00001038:00002202\nHID_NAME=SteelSeries Arctis Nova 7\n"
+            "HID_PHYS=usb-0000:00:14.0-2/input4\nHID_UNIQ=\n");
+    addNode("hidraw2",
+            "HID_ID=0003:00001038:00002202\nHID_NAME=SteelSeries Arctis Nova 7\n"
+            "HID_PHYS=usb-0000:00:14.0-4/input3\nHID_UNIQ=\n");
+    addNode("hidraw3",
+            "DRIVER=hid-generic\nHID_ID=0003:000003F0:0000098D\nHID_NAME=HyperX Cloud Alpha\n"
+            "HID_PHYS=usb-0000:00:14.0-6/input0\nHID_UNIQ=A1B2C3\n");
+}
+
+void TestDeviceRegistry::readsPhysicalUnits()
+{
+    QHash<quint32, QStringList> units = DeviceRegistry::physicalUnits(sysfs.path());
+
+    QCOMPARE(units.size(), 2);
+    // The interfaces of one dongle make one unit
+    QCOMPARE(units.value(0x10382202),
+             QStringList() << "usb-0000:00:14.0-2" << "usb-0000:00:14.0-4");
+    // A serial number wins over the port
+    QCOMPARE(units.value(0x03f0098d), QStringList() << "A1B2C3");
+
+    QVERIFY(DeviceRegistry::physicalUnits(sysfs.filePath("missing")).isEmpty());
+}
+
+void TestDeviceRegistry::namesUnitsAfterPhysicalUnits()
+{
+    QHash<quint32, QStringList> units = DeviceRegistry::physicalUnits(sysfs.path());
+    QList<Device> devices{createDevice("0x1038", "0x2202"),
+                          createDevice("0x03f0", "0x098d"),
+                          createDevice("0x1038", "0x2202")};
+    DeviceRegistry::assignUnitIds(devices, units);
+
+    QCOMPARE(devices.at(0).unit_id, QString("usb-0000:00:14.0-2"));
+    QCOMPARE(devices.at(1).unit_id, QString("A1B2C3"));
+    QCOMPARE(devices.at(2).unit_id, QString("usb-0000:00:14.0-4"));
+
+    // Statuses get the same names, so they still find their device
+    DeviceStatus status;
+    status.id_vendor = "0x1038";
+    status.id_product = "0x2202";
+    QList<DeviceStatus> statuses{status, status};
+    DeviceRegistry::assignUnitIds(statuses, units);
+    QCOMPARE(statuses.at(1).unit_id, devices.at(2).unit_id);
+}
+
+void TestDeviceRegistry::fallsBackToPosition()
+{
+    QHash<quint32, QStringList> units;
+    units.insert(0x10382202, QStringList() << "usb-0000:00:14.0-2");
+    QList<Device> devices{createDevice("0x1038", "0x2202"),
+                          createDevice("0x1038", "0x2202"),
+                          createDevice("0x1038", "0x12ad")};
+    DeviceRegistry::assignUnitIds(devices, units);
+
+    QCOMPARE(devices.at(0).unit_id, QString("usb-0000:00:14.0-2"));
+    QCOMPARE(devices.at(1).unit_id, QString("#1"));
+    QCOMPARE(devices.at(2).unit_id, QString("#0"));
+}
+
+void TestDeviceRegistry::keepsAssignedIds()
+{
+    QList<Device> devices{createDevice("0x1038", "0x2202")};
+    devices.first().unit_id = "saved";
+    DeviceRegistry::assignUnitIds(devices, DeviceRegistry::physicalUnits(sysfs.path()));
+    QCOMPARE(devices.first().unit_id, QString("saved"));
+}
+
+void TestDeviceRegistry::findsByKey()
+{
+    QList<Device> devices{createDevice("0x1038", "0x2202"), createDevice("0x1038", "0x2202")};
+    DeviceRegistry::assignUnitIds(devices, DeviceRegistry::physicalUnits(sysfs.path()));
+    DeviceRegistry registry(devices);
+
+    QCOMPARE(registry.size(), 2);
+    QCOMPARE(registry.find(DeviceKey(0x10382202, "usb-0000:00:14.0-4")), &devices[1]);
+    QCOMPARE(registry.find(DeviceKey(0x10382202, "#1")), nullptr);
+
+    registry.remove(&devices[0]);
+    QCOMPARE(registry.find(devices.at(0)), nullptr);
+}
+
+QTEST_GUILESS_MAIN(TestDeviceRegistry)
+#include "tst_deviceregistry.moc"
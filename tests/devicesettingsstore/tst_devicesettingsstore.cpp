@@ -0,0 +1,117 @@
+#include "devicesettingsstore.h"
+
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <memory>
+
+static Device createDevice(int lights)
+{
+    Device device;
+    device.device = "Arctis Nova 7";
+    device.id_vendor = "0x1038";
+    device.id_product = "0x2202";
+    // Saved files without one get renamed after the units plugged in now
+    device.unit_id = "usb-0000:00:14.0-4";
+    device.lights = lights;
+    return device;
+}
+
+class TestDeviceSettingsStore : public QObject
+{
+    Q_OBJECT
+
+private:
+    std::unique_ptr<QTemporaryDir> dir;
+
+    QString filePath() const;
+
+private slots:
+    void init();
+    void cleanup();
+
+    void coalescesUpdates();
+    void waitsForQuietPeriod();
+    void flushesWhenDestroyed();
+    void skipsWriteWithoutChanges();
+};
+
+void TestDeviceSettingsStore::init()
+{
+    dir = std::make_unique<QTemporaryDir>();
+    QVERIFY(dir->isValid());
+}
+
+void TestDeviceSettingsStore::cleanup()
+{
+    dir.reset();
+}
+
+QString TestDeviceSettingsStore::filePath() const
+{
+    return dir->filePath("devices.json");
+}
+
+void TestDeviceSettingsStore::coalescesUpdates()
+{
+    DeviceSettingsStore store(filePath());
+    for (int lights = 0; lights < 10; ++lights) {
+        store.update({createDevice(lights % 2)});
+    }
+    QVERIFY(store.isDirty());
+    QCOMPARE(store.writeCount(), 0);
+
+    QTRY_COMPARE_WITH_TIMEOUT(store.writeCount(), 1, 3000);
+    QVERIFY(!store.isDirty());
+    QCOMPARE(store.devices().size(), 1);
+
+    // Nothing left for another write
+    QTest::qWait(1500);
+    QCOMPARE(store.writeCount(), 1);
+    QList<Device> written = deserializeDevices(filePath());
+    QCOMPARE(written.size(), 1);
+    QCOMPARE(written.first().lights, 1);
+}
+
+void TestDeviceSettingsStore::waitsForQuietPeriod()
+{
+    DeviceSettingsStore store(filePath());
+
+    // Every update pushes the write back by the whole delay
+    for (int i = 0; i < 3; ++i) {
+        store.update({createDevice(i)});
+        QTest::qWait(500);
+    }
+    QCOMPARE(store.writeCount(), 0);
+    QTRY_COMPARE_WITH_TIMEOUT(store.writeCount(), 1, 3000);
+}
+
+void TestDeviceSettingsStore::flushesWhenDestroyed()
+{
+    auto store = std::make_unique<DeviceSettingsStore>(filePath());
+    store->update({createDevice(1)});
+    QCOMPARE(store->writeCount(), 0);
+    store.reset();
+
+    QList<Device> written = deserializeDevices(filePath());
+    QCOMPARE(written.size(), 1);
+    QCOMPARE(written.first().lights, 1);
+
+    // And the next start reads it back
+    DeviceSettingsStore reopened(filePath());
+    QCOMPARE(reopened.devices().size(), 1);
+    QVERIFY(!reopened.isDirty());
+}
+
+void TestDeviceSettingsStore::skipsWriteWithoutChanges()
+{
+    {
+        DeviceSettingsStore store(filePath());
+        store.flush();
+        QCOMPARE(store.writeCount(), 0);
+    }
+    QVERIFY(!QFile::exists(filePath()));
+}
+
+QTEST_GUILESS_MAIN(TestDeviceSettingsStore)
+#include "tst_devicesettingsstore.moc"
@@ -0,0 +1,16 @@
+include(../tests.pri)
+
+TARGET = tst_equalizerfit
+
+SOURCES += \
+    $$SRC_DIR/DataTypes/configfile.cpp \
+    $$SRC_DIR/DataTypes/device.cpp \
+    $$SRC_DIR/DataTypes/deviceregistry.cpp \
+    $$SRC_DIR/Utils/equalizerfit.cpp \
+    tst_equalizerfit.cpp
+
+HEADERS += \
+    $$SRC_DIR/DataTypes/configfile.h \
+    $$SRC_DIR/DataTypes/device.h \
+    $$SRC_DIR/DataTypes/deviceregistry.h \
+    $$SRC_DIR/Utils/equalizerfit.h
@@ -0,0 +1,198 @@
+#include "equalizerfit.h"
+
+#include <QRandomGenerator>
+#include <QTest>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+Q_DECLARE_METATYPE(Equalizer)
+
+// Log-spaced frequencies across the audible range, like a measurement
+static QList<double> audibleFrequencies(int count)
+{
+    QList<double> frequencies;
+    for (int i = 0; i < count; ++i) {
+        // Rounding must not push the last one past the 20 kHz the fit cuts at
+        frequencies.append(std::min(20000.0, 20 * std::pow(1000.0, double(i) / (count - 1))));
+    }
+    return frequencies;
+}
+
+// The response EqualizerFit models for gains (relative to the baseline) at frequency
+static double modelResponse(const EqualizerFit &fit, const QList<double> &gains, double frequency)
+{
+    const QList<double> centres = fit.bandFrequencies();
+    const double width = std::log2(centres.at(1) / centres.at(0));
+    double response = 0;
+    for (int i = 0; i < centres.size(); ++i) {
+        double octaves = std::log2(frequency / centres.at(i)) / width;
+        response += gains.at(i) * std::exp(-0.5 * octaves * octaves);
+    }
+    return response;
+}
+
+static QList<EqualizerFit::CurvePoint> randomTarget(int points, double range, quint32 seed)
+{
+    QRandomGenerator random(seed);
+    QList<EqualizerFit::CurvePoint> target;
+    for (double frequency : audibleFrequencies(points)) {
+        target.append({frequency, (random.generateDouble() * 2 - 1) * range});
+    }
+    return target;
+}
+
+class TestEqualizerFit : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void flatTargetGivesBaseline_data();
+    void flatTargetGivesBaseline();
+    void recoversSingleBand_data();
+    void recoversSingleBand();
+    void respectsDeviceLimits_data();
+    void respectsDeviceLimits();
+    void reportsRmsError();
+
+    void benchmarkFit32Bands_data();
+    void benchmarkFit32Bands();
+};
+
+void TestEqualizerFit::flatTargetGivesBaseline_data()
+{
+    QTest::addColumn<Equalizer>("equalizer");
+    QTest::addColumn<double>("level");
+
+    QTest::newRow("10 bands at 0 dB") << Equalizer(10, 0, 0.5, -10, 10) << 0.0;
+    QTest::newRow("10 bands at +4 dB") << Equalizer(10, 0, 0.5, -10, 10) << 4.0;
+    QTest::newRow("32 bands, baseline 5") << Equalizer(32, 5, 1, 0, 10) << -3.0;
+}
+
+void TestEqualizerFit::flatTargetGivesBaseline()
+{
+    QFETCH(Equalizer, equalizer);
+    QFETCH(double, level);
+
+    QList<EqualizerFit::CurvePoint> target;
+    for (double frequency : audibleFrequencies(200)) {
+        target.append({frequency, level});
+    }
+    double rmsError = -1;
+    QList<double> values = EqualizerFit(equalizer).fit(target, &rmsError);
+
+    QCOMPARE(values.size(), equalizer.bands_number);
+    for (double value : std::as_const(values)) {
+        QCOMPARE(value, double(equalizer.band_baseline));
+    }
+    QVERIFY(rmsError < 1e-6);
+}
+
+void TestEqualizerFit::recoversSingleBand_data()
+{
+    QTest::addColumn<int>("bands");
+    QTest::addColumn<int>("band");
+
+    QTest::newRow("10 bands, lowest") << 10 << 0;
+    QTest::newRow("10 bands, middle") << 10 << 3;
+    QTest::newRow("10 bands, highest") << 10 << 9;
+    QTest::newRow("32 bands, middle") << 32 << 17;
+}
+
+void TestEqualizerFit::recoversSingleBand()
+{
+    QFETCH(int, bands);
+    QFETCH(int, band);
+
+    const Equalizer equalizer(bands, 0, 0.5, -10, 10);
+    EqualizerFit fit(equalizer);
+    QList<double> gains(bands, 0.0);
+    gains[band] = 6;
+
+    // Exactly that band's response, at some overall level the fit ignores
+    QList<EqualizerFit::CurvePoint> target;
+    for (double frequency : audibleFrequencies(200)) {
+        target.append({frequency, modelResponse(fit, gains, frequency) + 3});
+    }
+    double rmsError = -1;
+    QCOMPARE(fit.fit(target, &rmsError), gains);
+    QVERIFY(rmsError < 1e-6);
+}
+
+void TestEqualizerFit::respectsDeviceLimits_data()
+{
+    QTest::addColumn<Equalizer>("equalizer");
+
+    QTest::newRow("half dB steps") << Equalizer(10, 0, 0.5, -6, 6);
+    QTest::newRow("whole dB, off-centre baseline") << Equalizer(10, 4, 1, 0, 12);
+    QTest::newRow("32 bands") << Equalizer(32, 0, 1, -12, 12);
+}
+
+void TestEqualizerFit::respectsDeviceLimits()
+{
+    QFETCH(Equalizer, equalizer);
+
+    // Far more than any device can follow
+    QList<double> values = EqualizerFit(equalizer).fit(randomTarget(200, 40, 7));
+    QCOMPARE(values.size(), equalizer.bands_number);
+    for (double value : std::as_const(values)) {
+        QVERIFY2(value >= equalizer.band_min && value <= equalizer.band_max,
+                 qPrintable(QString::number(value)));
+        double steps = value / equalizer.band_step;
+        QVERIFY2(std::abs(steps - std::round(steps)) < 1e-9, qPrintable(QString::number(value)));
+    }
+}
+
+void TestEqualizerFit::reportsRmsError()
+{
+    const Equalizer equalizer(10, 0, 0.5, -10, 10);
+    EqualizerFit fit(equalizer);
+    const QList<EqualizerFit::CurvePoint> target = randomTarget(150, 8, 11);
+
+    double rmsError = -1;
+    QList<double> values = fit.fit(target, &rmsError);
+    QCOMPARE(values.size(), 10);
+
+    // What is left once the fitted response and the best overall level are taken out
+    QList<double> residuals;
+    for (const EqualizerFit::CurvePoint &point : target) {
+        residuals.append(point.gain - modelResponse(fit, values, point.frequency));
+    }
+    double mean = std::accumulate(residuals.begin(), residuals.end(), 0.0) / residuals.size();
+    double squares = 0;
+    for (double residual : std::as_const(residuals)) {
+        squares += (residual - mean) * (residual - mean);
+    }
+    double expected = std::sqrt(squares / residuals.size());
+
+    QVERIFY(expected > 0);
+    QVERIFY2(std::abs(rmsError - expected) < 1e-6,
+             qPrintable(QString("%1 != %2").arg(rmsError).arg(expected)));
+}
+
+void TestEqualizerFit::benchmarkFit32Bands_data()
+{
+    QTest::addColumn<int>("points");
+
+    // GraphicEQ files carry 127 points, raw measurements several hundred
+    QTest::newRow("127 points") << 127;
+    QTest::newRow("1000 points") << 1000;
+}
+
+void TestEqualizerFit::benchmarkFit32Bands()
+{
+    QFETCH(int, points);
+
+    const EqualizerFit fit(Equalizer(32, 0, 1, -12, 12));
+    const QList<EqualizerFit::CurvePoint> target = randomTarget(points, 10, 3);
+
+    QList<double> values;
+    QBENCHMARK {
+        values = fit.fit(target);
+    }
+    QCOMPARE(values.size(), 32);
+}
+
+QTEST_GUILESS_MAIN(TestEqualizerFit)
+#include "tst_equalizerfit.moc"
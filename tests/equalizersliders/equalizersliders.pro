@@ -0,0 +1,20 @@
+include(../tests.pri)
+
+QT += widgets
+
+INCLUDEPATH += $$SRC_DIR/UI
+
+TARGET = tst_equalizersliders
+
+SOURCES += \
+    $$SRC_DIR/DataTypes/configfile.cpp \
+    $$SRC_DIR/DataTypes/device.cpp \
+    $$SRC_DIR/DataTypes/deviceregistry.cpp \
+    $$SRC_DIR/UI/equalizersliders.cpp \
+    tst_equalizersliders.cpp
+
+HEADERS += \
+    $$SRC_DIR/DataTypes/configfile.h \
+    $$SRC_DIR/DataTypes/device.h \
+    $$SRC_DIR/DataTypes/deviceregistry.h \
+    $$SRC_DIR/UI/equalizersliders.h
@@ -0,0 +1,123 @@
+#include "equalizersliders.h"
+
+#include <QTest>
+#include <QWidget>
+
+// Two curves to alternate between, as when switching between two headsets of one model
+static QList<QList<double>> makeCurves(int bands)
+{
+    QList<double> first;
+    QList<double> second;
+    for (int i = 0; i < bands; ++i) {
+        first.append(i % 5 - 2);
+        second.append(2 - i % 5);
+    }
+    return {first, second};
+}
+
+class TestEqualizerSliders : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Lets the benchmark run without a display
+    static void initMain()
+    {
+        if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+        }
+    }
+
+private slots:
+    void keepsSlidersForSameBandCount();
+    void showsCurveOrBaseline();
+
+    void benchmarkSwitchDevices_data();
+    void benchmarkSwitchDevices();
+};
+
+void TestEqualizerSliders::keepsSlidersForSameBandCount()
+{
+    QWidget host;
+    QHBoxLayout *layout = new QHBoxLayout(&host);
+    EqualizerSliders sliders;
+
+    sliders.configure(layout, Equalizer(10, 0, 0.5, -10, 10), {});
+    QCOMPARE(sliders.sliders().size(), 10);
+    QCOMPARE(layout->count(), 10);
+    QList<QSlider *> first = sliders.sliders();
+
+    sliders.configure(layout, Equalizer(10, 0, 1, -12, 12), {});
+    QCOMPARE(sliders.sliders(), first);
+    QCOMPARE(first.last()->maximum(), 12);
+
+    // Growing keeps the existing ones, shrinking removes only the extra columns
+    sliders.configure(layout, Equalizer(32, 0, 0.5, -10, 10), {});
+    QCOMPARE(sliders.sliders().size(), 32);
+    QCOMPARE(layout->count(), 32);
+    QCOMPARE(sliders.sliders().mid(0, 10), first);
+
+    sliders.configure(layout, Equalizer(10, 0, 0.5, -10, 10), {});
+    QCOMPARE(sliders.sliders(), first);
+    QCOMPARE(layout->count(), 10);
+
+    sliders.resize(layout, 0);
+    QVERIFY(sliders.isEmpty());
+    QCOMPARE(layout->count(), 0);
+}
+
+void TestEqualizerSliders::showsCurveOrBaseline()
+{
+    QWidget host;
+    QHBoxLayout *layout = new QHBoxLayout(&host);
+    EqualizerSliders sliders;
+    QList<QList<double>> curves = makeCurves(10);
+
+    sliders.configure(layout, Equalizer(10, 0, 0.5, -10, 10), curves.first());
+    QCOMPARE(sliders.sliders().at(0)->value(), -2);
+    QCOMPARE(sliders.sliders().at(4)->value(), 2);
+
+    // A curve saved for another band count doesn't fit
+    sliders.configure(layout, Equalizer(10, 1, 0.5, -10, 10), makeCurves(32).first());
+    QCOMPARE(sliders.sliders().at(0)->value(), 1);
+    QCOMPARE(sliders.sliders().at(4)->value(), 1);
+}
+
+void TestEqualizerSliders::benchmarkSwitchDevices_data()
+{
+    QTest::addColumn<int>("bands");
+    QTest::addColumn<bool>("rebuild");
+
+    QTest::newRow("10 bands, reused") << 10 << false;
+    QTest::newRow("10 bands, rebuilt") << 10 << true;
+    QTest::newRow("32 bands, reused") << 32 << false;
+    QTest::newRow("32 bands, rebuilt") << 32 << true;
+}
+
+void TestEqualizerSliders::benchmarkSwitchDevices()
+{
+    QFETCH(int, bands);
+    QFETCH(bool, rebuild);
+
+    QWidget host;
+    QHBoxLayout *layout = new QHBoxLayout(&host);
+    host.show();
+    EqualizerSliders sliders;
+    const Equalizer equalizer(bands, 0, 0.5, -10, 10);
+    const QList<QList<double>> curves = makeCurves(bands);
+    sliders.configure(layout, equalizer, curves.first());
+
+    // "rebuilt" is what every device switch did before the sliders were kept
+    int switches = 0;
+    QBENCHMARK {
+        if (rebuild) {
+            sliders.resize(layout, 0);
+        }
+        sliders.configure(layout, equalizer, curves.at(++switches % 2));
+        layout->activate();
+    }
+    QCOMPARE(sliders.sliders().size(), bands);
+}
+
+QTEST_MAIN(TestEqualizerSliders)
+#include "tst_equalizersliders.moc"
@@ -0,0 +1,29 @@
+# HeadsetControlAPI and the transports behind it, without any UI
+SOURCES += \
+    $$SRC_DIR/DataTypes/command.cpp \
+    $$SRC_DIR/DataTypes/configfile.cpp \
+    $$SRC_DIR/DataTypes/device.cpp \
+    $$SRC_DIR/DataTypes/devicemetadatacache.cpp \
+    $$SRC_DIR/DataTypes/deviceregistry.cpp \
+    $$SRC_DIR/Utils/faketransport.cpp \
+    $$SRC_DIR/Utils/headsetcontrolapi.cpp \
+    $$SRC_DIR/Utils/headsetcontrolparser.cpp \
+    $$SRC_DIR/Utils/headsetcontrolstream.cpp \
+    $$SRC_DIR/Utils/headsettransport.cpp \
+    $$SRC_DIR/Utils/processsupervisor.cpp \
+    $$SRC_DIR/Utils/subprocesstransport.cpp
+
+HEADERS += \
+    $$SRC_DIR/DataTypes/command.h \
+    $$SRC_DIR/DataTypes/configfile.h \
+    $$SRC_DIR/DataTypes/device.h \
+    $$SRC_DIR/DataTypes/devicemetadatacache.h \
+    $$SRC_DIR/DataTypes/deviceregistry.h \
+    $$SRC_DIR/Utils/faketransport.h \
+    $$SRC_DIR/Utils/headsetcontrolapi.h \
+    $$SRC_DIR/Utils/headsetcontrolparser.h \
+    $$SRC_DIR/Utils/headsetcontrolstream.h \
+    $$SRC_DIR/Utils/headsettransport.h \
+    $$SRC_DIR/Utils/processsupervisor.h \
+    $$SRC_DIR/Utils/snapshotpublisher.h \
+    $$SRC_DIR/Utils/subprocesstransport.h
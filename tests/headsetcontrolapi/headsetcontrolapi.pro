@@ -0,0 +1,7 @@
+include(../tests.pri)
+include(../headsetcontrolapi.pri)
+
+TARGET = tst_headsetcontrolapi
+
+SOURCES += \
+    tst_headsetcontrolapi.cpp
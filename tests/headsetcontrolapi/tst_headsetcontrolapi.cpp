@@ -0,0 +1,139 @@
+#include "faketransport.h"
+#include "headsetcontrolapi.h"
+
+#include <QSignalSpy>
+#include <QTest>
+
+// Drives HeadsetControlAPI against FakeTransport, which records every command it gets
+class TestHeadsetControlAPI : public QObject
+{
+    Q_OBJECT
+
+private:
+    FakeTransport *transport = nullptr;
+    HeadsetControlAPI *api = nullptr;
+
+private slots:
+    void init();
+    void cleanup();
+
+    void enumeratesDevices();
+    void appliesCommand();
+    void coalescesSupersededValues();
+    void sendsBatchTogether();
+    void reportsOnlySuccessfulCommands();
+    void publishesStatus();
+};
+
+void TestHeadsetControlAPI::init()
+{
+    transport = new FakeTransport();
+    // Takes ownership of the transport
+    api = new HeadsetControlAPI(transport);
+}
+
+void TestHeadsetControlAPI::cleanup()
+{
+    delete api;
+    api = nullptr;
+    transport = nullptr;
+}
+
+void TestHeadsetControlAPI::enumeratesDevices()
+{
+    QFuture<QList<Device>> future = api->getConnectedDevices();
+    QTRY_VERIFY(future.isFinished());
+
+    QList<Device> devices = future.result();
+    QCOMPARE(devices.size(), 1);
+    QCOMPARE(devices.first().device, QString("HeadsetControl Test device"));
+    QVERIFY(devices.first().capabilities.contains("CAP_EQUALIZER"));
+    QCOMPARE(devices.first().presets_list.size(), 4);
+    QCOMPARE(api->getName(), QString("FakeTransport"));
+}
+
+void TestHeadsetControlAPI::appliesCommand()
+{
+    QSignalSpy applied(api, &HeadsetControlAPI::settingApplied);
+
+    api->setSidetone(64);
+    QTRY_COMPARE(applied.count(), 1);
+
+    QCOMPARE(applied.first().at(0).toString(), QString("CAP_SIDETONE"));
+    QCOMPARE(applied.first().at(1).toInt(), 64);
+    QCOMPARE(transport->appliedCommands.size(), 1);
+    QCOMPARE(transport->appliedCommands.first().flag, QString("--sidetone"));
+    QCOMPARE(transport->devices.first().sidetone, 64);
+}
+
+void TestHeadsetControlAPI::coalescesSupersededValues()
+{
+    QSignalSpy applied(api, &HeadsetControlAPI::settingApplied);
+
+    // All within one batch window: only the last value is worth sending
+    api->setSidetone(10);
+    api->setSidetone(20);
+    api->setSidetone(30);
+    QTRY_COMPARE(applied.count(), 1);
+
+    QCOMPARE(transport->appliedCommands.size(), 1);
+    QCOMPARE(transport->appliedCommands.first().argument, QString("30"));
+}
+
+void TestHeadsetControlAPI::sendsBatchTogether()
+{
+    QSignalSpy succeeded(api, &HeadsetControlAPI::actionSuccesful);
+
+    api->beginBatch();
+    api->setLights(true);
+    api->setInactiveTime(15);
+    QCOMPARE(transport->appliedCommands.size(), 0);
+    api->commitBatch();
+
+    // Committing sends the batch right away, in a single apply()
+    QCOMPARE(transport->appliedCommands.size(), 2);
+    QTRY_COMPARE(succeeded.count(), 1);
+    QCOMPARE(transport->devices.first().lights, 1);
+    QCOMPARE(transport->devices.first().inactive_time, 15);
+}
+
+void TestHeadsetControlAPI::reportsOnlySuccessfulCommands()
+{
+    QSignalSpy applied(api, &HeadsetControlAPI::settingApplied);
+    transport->failingCapabilities.insert("CAP_LIGHTS");
+
+    api->beginBatch();
+    api->setLights(true);
+    api->setSidetone(5);
+    api->commitBatch();
+    QTRY_COMPARE(applied.count(), 1);
+
+    QCOMPARE(applied.first().at(0).toString(), QString("CAP_SIDETONE"));
+    QCOMPARE(transport->devices.first().lights, -1);
+
+    // The failed capability isn't left blocked
+    transport->failingCapabilities.clear();
+    api->setLights(true);
+    QTRY_COMPARE(applied.count(), 2);
+    QCOMPARE(transport->devices.first().lights, 1);
+}
+
+void TestHeadsetControlAPI::publishesStatus()
+{
+    int updates = 0;
+    connect(api, &HeadsetControlAPI::statusUpdated, this, [&updates]() { updates++; });
+    QCOMPARE(api->getState()->sequence, quint64(0));
+
+    QFuture<QList<DeviceStatus>> future = api->getStatus();
+    QTRY_VERIFY(future.isFinished());
+
+    std::shared_ptr<const DeviceState> state = api->getState();
+    QCOMPARE(state->sequence, quint64(1));
+    QCOMPARE(state->statuses.size(), 1);
+    QCOMPARE(state->statuses.first().battery.level, 42);
+    QCOMPARE(state->statuses.first().chatmix, 42);
+    QCOMPARE(updates, 1);
+}
+
+QTEST_GUILESS_MAIN(TestHeadsetControlAPI)
+#include "tst_headsetcontrolapi.moc"
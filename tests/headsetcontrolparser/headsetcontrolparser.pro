@@ -0,0 +1,23 @@
+include(../tests.pri)
+include(../common/allocationcounter.pri)
+
+TARGET = tst_headsetcontrolparser
+
+SOURCES += \
+    $$SRC_DIR/DataTypes/command.cpp \
+    $$SRC_DIR/DataTypes/configfile.cpp \
+    $$SRC_DIR/DataTypes/device.cpp \
+    $$SRC_DIR/DataTypes/devicemetadatacache.cpp \
+    $$SRC_DIR/DataTypes/deviceregistry.cpp \
+    $$SRC_DIR/DataTypes/devicestore.cpp \
+    $$SRC_DIR/Utils/headsetcontrolparser.cpp \
+    tst_headsetcontrolparser.cpp
+
+HEADERS += \
+    $$SRC_DIR/DataTypes/command.h \
+    $$SRC_DIR/DataTypes/configfile.h \
+    $$SRC_DIR/DataTypes/device.h \
+    $$SRC_DIR/DataTypes/devicemetadatacache.h \
+    $$SRC_DIR/DataTypes/deviceregistry.h \
+    $$SRC_DIR/DataTypes/devicestore.h \
+    $$SRC_DIR/Utils/headsetcontrolparser.h
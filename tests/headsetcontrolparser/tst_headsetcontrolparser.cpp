@@ -0,0 +1,304 @@
+#include "allocationcounter.h"
+#include "devicestore.h"
+#include "headsetcontrolparser.h"
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QTest>
+
+// What every poll did before HeadsetControlParser: stdout went through a QString and
+// back into a QJsonDocument, and each device ran a regex over the whole output to
+// recover the order of its equalizer presets
+static QList<Device> parseWithJsonDocument(const QByteArray &stdoutBytes)
+{
+    QString output = QString::fromUtf8(stdoutBytes);
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(output.toUtf8());
+    QJsonArray jsonDevices = jsonDoc.object()["devices"].toArray();
+
+    QList<Device> devices;
+    for (const QJsonValue &jsonDevice : jsonDevices) {
+        QJsonObject jsonObj = jsonDevice.toObject();
+        Device device;
+        device.status = jsonObj["status"].toString();
+        device.device = jsonObj["device"].toString();
+        device.vendor = jsonObj["vendor"].toString();
+        device.product = jsonObj["product"].toString();
+        device.id_vendor = jsonObj["id_vendor"].toString();
+        device.id_product = jsonObj["id_product"].toString();
+
+        for (const QJsonValue &value : jsonObj["capabilities"].toArray()) {
+            device.capabilities.insert(value.toString());
+        }
+        if (device.capabilities.contains("CAP_BATTERY_STATUS")) {
+            QJsonObject jBattery = jsonObj["battery"].toObject();
+            device.battery = Battery(jBattery["status"].toString(), jBattery["level"].toInt());
+        }
+        if (device.capabilities.contains("CAP_CHATMIX_STATUS")) {
+            device.chatmix = jsonObj["chatmix"].toInt();
+        }
+        if (device.capabilities.contains("CAP_EQUALIZER_PRESET")
+            && jsonObj["equalizer_presets"].isObject()) {
+            QJsonObject equalizerPresets = jsonObj["equalizer_presets"].toObject();
+            static QRegularExpression re("\"(\\w+)\":\\s*\\[");
+            QRegularExpressionMatchIterator i = re.globalMatch(output);
+            while (i.hasNext()) {
+                QString presetName = i.next().captured(1);
+                if (equalizerPresets.contains(presetName)) {
+                    EqualizerPreset preset;
+                    preset.name = presetName;
+                    for (const QJsonValue &value : equalizerPresets[presetName].toArray()) {
+                        preset.values.append(value.toDouble());
+                    }
+                    device.presets_list.append(preset);
+                }
+            }
+        }
+        if (device.capabilities.contains("CAP_EQUALIZER")) {
+            QJsonObject jEq = jsonObj["equalizer"].toObject();
+            device.equalizer = Equalizer(jEq["bands"].toInt(),
+                                         jEq["baseline"].toInt(),
+                                         jEq["step"].toDouble(),
+                                         jEq["min"].toInt(),
+                                         jEq["max"].toInt());
+            device.equalizer_curve = QList<double>(device.equalizer.bands_number,
+                                                   device.equalizer.band_baseline);
+        }
+        devices.append(device);
+    }
+    return devices;
+}
+
+class TestHeadsetControlParser : public QObject
+{
+    Q_OBJECT
+
+private:
+    QByteArray output;
+
+private slots:
+    void initTestCase();
+
+    void parsesDevices();
+    void keepsPresetOrder();
+    void reusesCachedMetadata();
+    void overwritesReusedDevices();
+    void overwritesReusedDevices_data();
+    void parsesStatus();
+    void rejectsMalformedOutput();
+    void allocatesLessThanJsonDocument();
+    void allocatesNothingOnSteadyPoll();
+
+    void benchmarkStreaming();
+    void benchmarkStreamingCold();
+    void benchmarkJsonDocument();
+};
+
+void TestHeadsetControlParser::initTestCase()
+{
+    QFile file(QFINDTESTDATA("../data/headsetcontrol_devices.json"));
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    output = file.readAll();
+}
+
+void TestHeadsetControlParser::parsesDevices()
+{
+    HeadsetControlOutput parsed;
+    QVERIFY(HeadsetControlParser().parse(output, parsed));
+
+    QCOMPARE(parsed.name, QString("HeadsetControl"));
+    QCOMPARE(parsed.version, QString("3.0.0"));
+    QCOMPARE(parsed.devices.size(), 2);
+
+    const Device &nova = parsed.devices.at(0);
+    QCOMPARE(nova.device, QString("SteelSeries Arctis Nova 7"));
+    QCOMPARE(nova.id_vendor, QString("0x1038"));
+    QCOMPARE(nova.id_product, QString("0x2202"));
+    QCOMPARE(nova.capabilities.size(), 11);
+    QCOMPARE(nova.battery.status, QString("BATTERY_AVAILABLE"));
+    QCOMPARE(nova.battery.level, 75);
+    QCOMPARE(nova.chatmix, 64);
+    QCOMPARE(nova.equalizer.bands_number, 10);
+    QCOMPARE(nova.equalizer.band_step, 0.5);
+    QCOMPARE(nova.equalizer.band_min, -10);
+    QCOMPARE(nova.equalizer_curve.size(), 10);
+
+    const Device &cloud = parsed.devices.at(1);
+    QCOMPARE(cloud.battery.status, QString("BATTERY_CHARGING"));
+    QCOMPARE(cloud.battery.level, 40);
+    QVERIFY(cloud.presets_list.isEmpty());
+    QCOMPARE(cloud.equalizer.bands_number, 0);
+
+    // Same result as the QJsonDocument path it replaces
+    QList<Device> reference = parseWithJsonDocument(output);
+    QCOMPARE(reference.size(), parsed.devices.size());
+    for (int i = 0; i < reference.size(); ++i) {
+        QCOMPARE(parsed.devices.at(i).capabilities, reference.at(i).capabilities);
+        QCOMPARE(parsed.devices.at(i).battery.level, reference.at(i).battery.level);
+        QCOMPARE(parsed.devices.at(i).presets_list.size(), reference.at(i).presets_list.size());
+    }
+}
+
+void TestHeadsetControlParser::keepsPresetOrder()
+{
+    HeadsetControlOutput parsed;
+    QVERIFY(HeadsetControlParser().parse(output, parsed));
+
+    // Not alphabetical: a QJsonObject would have sorted them
+    const QList<EqualizerPreset> &presets = parsed.devices.first().presets_list;
+    QCOMPARE(presets.size(), 4);
+    QCOMPARE(presets.at(0).name, QString("flat"));
+    QCOMPARE(presets.at(1).name, QString("bass"));
+    QCOMPARE(presets.at(2).name, QString("focus"));
+    QCOMPARE(presets.at(3).name, QString("smiley"));
+    QCOMPARE(presets.at(1).values.size(), 10);
+    QCOMPARE(presets.at(1).values.at(0), 3.5);
+    QCOMPARE(presets.at(2).values.at(0), -5.0);
+}
+
+void TestHeadsetControlParser::reusesCachedMetadata()
+{
+    DeviceMetadataCache cache;
+    HeadsetControlOutput first;
+    QVERIFY(HeadsetControlParser(&cache).parse(output, first));
+    QVERIFY(cache.find(DeviceKey::packId("0x1038", "0x2202")) != nullptr);
+
+    // The second pass takes the static fields from the cache, the dynamic ones from the output
+    QByteArray changed = output;
+    changed.replace("\"level\": 75", "\"level\": 74");
+    HeadsetControlOutput second;
+    QVERIFY(HeadsetControlParser(&cache).parse(changed, second));
+    QCOMPARE(second.devices.size(), 2);
+    QCOMPARE(second.devices.first().battery.level, 74);
+    QCOMPARE(second.devices.first().presets_list.size(), 4);
+    QCOMPARE(second.devices.first().capabilities, first.devices.first().capabilities);
+}
+
+void TestHeadsetControlParser::overwritesReusedDevices_data()
+{
+    QTest::addColumn<bool>("withCache");
+
+    QTest::newRow("cached") << true;
+    QTest::newRow("uncached") << false;
+}
+
+void TestHeadsetControlParser::overwritesReusedDevices()
+{
+    QFETCH(bool, withCache);
+    DeviceMetadataCache cache;
+    DeviceMetadataCache *metadataCache = withCache ? &cache : nullptr;
+
+    HeadsetControlOutput parsed;
+    QVERIFY(HeadsetControlParser(metadataCache).parse(output, parsed));
+
+    // The Nova 7 unplugged: the HyperX now lands where the Nova 7 was
+    QJsonObject root = QJsonDocument::fromJson(output).object();
+    QJsonArray devices = root["devices"].toArray();
+    devices.removeFirst();
+    root["devices"] = devices;
+    QVERIFY(HeadsetControlParser(metadataCache).parse(QJsonDocument(root).toJson(), parsed));
+
+    QCOMPARE(parsed.devices.size(), 1);
+    const Device &cloud = parsed.devices.first();
+    QCOMPARE(cloud.id_product, QString("0x098d"));
+    QCOMPARE(cloud.battery.status, QString("BATTERY_CHARGING"));
+    QVERIFY(!cloud.capabilities.contains("CAP_EQUALIZER"));
+    QVERIFY(cloud.presets_list.isEmpty());
+    QVERIFY(cloud.equalizer_curve.isEmpty());
+    QCOMPARE(cloud.equalizer.bands_number, 0);
+    QCOMPARE(cloud.chatmix, 65);
+}
+
+void TestHeadsetControlParser::parsesStatus()
+{
+    QList<DeviceStatus> statuses;
+    QVERIFY(HeadsetControlParser().parseStatus(output, statuses));
+
+    QCOMPARE(statuses.size(), 2);
+    QCOMPARE(statuses.at(0).id_product, QString("0x2202"));
+    QVERIFY(statuses.at(0).has_battery);
+    QVERIFY(statuses.at(0).has_chatmix);
+    QCOMPARE(statuses.at(0).chatmix, 64);
+    QVERIFY(statuses.at(1).has_battery);
+    QVERIFY(!statuses.at(1).has_chatmix);
+}
+
+void TestHeadsetControlParser::rejectsMalformedOutput()
+{
+    HeadsetControlOutput parsed;
+    QVERIFY(!HeadsetControlParser().parse(output.left(output.size() / 2), parsed));
+    QVERIFY(parsed.devices.isEmpty());
+    QVERIFY(!HeadsetControlParser().parse(QByteArray(), parsed));
+}
+
+void TestHeadsetControlParser::allocatesLessThanJsonDocument()
+{
+    DeviceMetadataCache cache;
+    HeadsetControlOutput parsed;
+    HeadsetControlParser(&cache).parse(output, parsed);
+
+    // A steady poll: the devices are known, the output object is reused
+    quint64 before = allocationCount();
+    HeadsetControlParser(&cache).parse(output, parsed);
+    quint64 streaming = allocationCount() - before;
+
+    before = allocationCount();
+    QList<Device> reference = parseWithJsonDocument(output);
+    quint64 jsonDocument = allocationCount() - before;
+
+    qDebug() << "Allocations per poll: streaming" << streaming << "QJsonDocument" << jsonDocument;
+    QVERIFY(streaming < jsonDocument);
+}
+
+void TestHeadsetControlParser::allocatesNothingOnSteadyPoll()
+{
+    DeviceMetadataCache cache;
+    HeadsetControlOutput parsed;
+    DeviceStore store;
+    QVERIFY(HeadsetControlParser(&cache).parse(output, parsed));
+    store.assign(parsed.devices);
+
+    // Same devices, same output object, same store: every string and list is reused
+    quint64 before = allocationCount();
+    bool ok = HeadsetControlParser(&cache).parse(output, parsed);
+    store.assign(parsed.devices);
+    quint64 allocations = allocationCount() - before;
+
+    QVERIFY(ok);
+    QCOMPARE(allocations, quint64(0));
+    QCOMPARE(store.size(), 2);
+    QCOMPARE(store.at(0).battery.level, 75);
+}
+
+void TestHeadsetControlParser::benchmarkStreaming()
+{
+    DeviceMetadataCache cache;
+    HeadsetControlOutput parsed;
+    HeadsetControlParser(&cache).parse(output, parsed);
+
+    QBENCHMARK {
+        HeadsetControlParser(&cache).parse(output, parsed);
+    }
+}
+
+void TestHeadsetControlParser::benchmarkStreamingCold()
+{
+    // First sight of every device: all static fields are decoded
+    QBENCHMARK {
+        HeadsetControlOutput parsed;
+        HeadsetControlParser().parse(output, parsed);
+    }
+}
+
+void TestHeadsetControlParser::benchmarkJsonDocument()
+{
+    QBENCHMARK {
+        QList<Device> devices = parseWithJsonDocument(output);
+        Q_UNUSED(devices);
+    }
+}
+
+QTEST_GUILESS_MAIN(TestHeadsetControlParser)
+#include "tst_headsetcontrolparser.moc"
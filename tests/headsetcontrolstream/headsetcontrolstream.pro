@@ -0,0 +1,10 @@
+include(../tests.pri)
+
+TARGET = tst_headsetcontrolstream
+
+SOURCES += \
+    $$SRC_DIR/Utils/headsetcontrolstream.cpp \
+    tst_headsetcontrolstream.cpp
+
+HEADERS += \
+    $$SRC_DIR/Utils/headsetcontrolstream.h
@@ -0,0 +1,183 @@
+#include "headsetcontrolstream.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <fcntl.h>
+#include <memory>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Runs HeadsetControlStream against a fake headsetcontrol that prints one document
+// when launched and then copies whatever the test writes into a named pipe, so the
+// test decides how the output is cut into reads
+class TestHeadsetControlStream : public QObject
+{
+    Q_OBJECT
+
+private:
+    static constexpr char LAUNCHED[] = "{\"launched\": true}";
+    // A string holding braces, an escaped quote and a nested object
+    static constexpr char DOCUMENT[] = "{\"name\": \"a } \\\" {\", \"battery\": {\"level\": 80}}";
+
+    std::unique_ptr<QTemporaryDir> dir;
+    std::unique_ptr<HeadsetControlStream> stream;
+    QList<QByteArray> documents;
+    int writeFd = -1;
+
+    QString pipePath() const;
+    bool launch();
+    bool openPipe();
+    bool write(const QByteArray &chunk);
+
+private slots:
+    void init();
+    void cleanup();
+
+    void splitsDocumentAcrossReads_data();
+    void splitsDocumentAcrossReads();
+    void splitsSeveralDocumentsInOneRead();
+    void ignoresBracesInStrings();
+    void restartsAfterExit();
+};
+
+void TestHeadsetControlStream::init()
+{
+    dir = std::make_unique<QTemporaryDir>();
+    QVERIFY(dir->isValid());
+    QVERIFY(::mkfifo(QFile::encodeName(pipePath()).constData(), 0600) == 0);
+
+    // Ignores the --output and --follow arguments the stream passes
+    QFile script(dir->filePath("headsetcontrol"));
+    QVERIFY(script.open(QIODevice::WriteOnly));
+    script.write("#!/bin/sh\n");
+    script.write("printf '%s\\n' '" + QByteArray(LAUNCHED) + "'\n");
+    script.write("exec cat '" + QFile::encodeName(pipePath()) + "'\n");
+    script.close();
+    QVERIFY(script.setPermissions(script.permissions() | QFileDevice::ExeOwner));
+
+    documents.clear();
+    stream = std::make_unique<HeadsetControlStream>(script.fileName());
+    connect(stream.get(),
+            &HeadsetControlStream::documentReceived,
+            this,
+            [this](const QByteArray &document) { documents.append(document); });
+}
+
+void TestHeadsetControlStream::cleanup()
+{
+    stream.reset();
+    if (writeFd >= 0) {
+        ::close(writeFd);
+        writeFd = -1;
+    }
+    dir.reset();
+}
+
+QString TestHeadsetControlStream::pipePath() const
+{
+    return dir->filePath("stdout");
+}
+
+bool TestHeadsetControlStream::launch()
+{
+    stream->start(1);
+    return QTest::qWaitFor([this]() { return !documents.isEmpty(); }, 5000)
+           && documents.first() == LAUNCHED && openPipe();
+}
+
+bool TestHeadsetControlStream::openPipe()
+{
+    // Only succeeds once the fake headsetcontrol has the pipe open for reading
+    return QTest::qWaitFor(
+        [this]() {
+            writeFd = ::open(QFile::encodeName(pipePath()).constData(), O_WRONLY | O_NONBLOCK);
+            return writeFd >= 0;
+        },
+        5000);
+}
+
+bool TestHeadsetControlStream::write(const QByteArray &chunk)
+{
+    if (::write(writeFd, chunk.constData(), chunk.size()) != chunk.size()) {
+        return false;
+    }
+    // Long enough for the stream to have read it before the next chunk comes
+    QTest::qWait(100);
+    return true;
+}
+
+void TestHeadsetControlStream::splitsDocumentAcrossReads_data()
+{
+    const QByteArray document(DOCUMENT);
+    QTest::addColumn<int>("split");
+
+    QTest::newRow("inside a key") << 3;
+    QTest::newRow("after a brace in a string") << int(document.indexOf('}')) + 1;
+    QTest::newRow("after an escape") << int(document.indexOf('\\')) + 1;
+    QTest::newRow("inside a nested object") << int(document.indexOf("80"));
+    QTest::newRow("before the last brace") << int(document.size()) - 1;
+}
+
+void TestHeadsetControlStream::splitsDocumentAcrossReads()
+{
+    QFETCH(int, split);
+    const QByteArray document(DOCUMENT);
+    QVERIFY(launch());
+
+    QVERIFY(write(document.first(split)));
+    QCOMPARE(documents.size(), 1);
+    QVERIFY(write(document.sliced(split) + "\n"));
+    QTRY_COMPARE(documents.size(), 2);
+    QCOMPARE(documents.last(), document);
+}
+
+void TestHeadsetControlStream::splitsSeveralDocumentsInOneRead()
+{
+    QVERIFY(launch());
+
+    // The last one is only finished by the next read
+    QVERIFY(write("{\"a\": 1}\n{\"b\": {\"c\": 2}}{\"d\": 3}\n{\"e\": "));
+    QCOMPARE(documents.size(), 4);
+    QCOMPARE(documents.at(1), QByteArray("{\"a\": 1}"));
+    QCOMPARE(documents.at(2), QByteArray("{\"b\": {\"c\": 2}}"));
+    QCOMPARE(documents.at(3), QByteArray("{\"d\": 3}"));
+
+    QVERIFY(write("4}\n"));
+    QTRY_COMPARE(documents.size(), 5);
+    QCOMPARE(documents.last(), QByteArray("{\"e\": 4}"));
+}
+
+void TestHeadsetControlStream::ignoresBracesInStrings()
+{
+    QVERIFY(launch());
+
+    QVERIFY(write("{\"a\": \"}\"}{\"b\": \"\\\"{\\\\\"}{\"c\": \"{{\"}"));
+    QCOMPARE(documents.size(), 4);
+    QCOMPARE(documents.at(1), QByteArray("{\"a\": \"}\"}"));
+    QCOMPARE(documents.at(2), QByteArray("{\"b\": \"\\\"{\\\\\"}"));
+    QCOMPARE(documents.at(3), QByteArray("{\"c\": \"{{\"}"));
+}
+
+void TestHeadsetControlStream::restartsAfterExit()
+{
+    QVERIFY(launch());
+
+    // Dies halfway through a document, which must not swallow the next launch's output
+    QVERIFY(write("{\"battery\": {\"level\": "));
+    ::close(writeFd);
+    writeFd = -1;
+
+    QTRY_COMPARE_WITH_TIMEOUT(documents.size(), 2, 5000);
+    QCOMPARE(documents.last(), QByteArray(LAUNCHED));
+    QVERIFY(stream->isRunning());
+
+    QVERIFY(openPipe());
+    QVERIFY(write(QByteArray(DOCUMENT) + "\n"));
+    QTRY_COMPARE(documents.size(), 3);
+    QCOMPARE(documents.last(), QByteArray(DOCUMENT));
+}
+
+QTEST_GUILESS_MAIN(TestHeadsetControlStream)
+#include "tst_headsetcontrolstream.moc"
@@ -0,0 +1,10 @@
+include(../tests.pri)
+
+TARGET = tst_hotplugmonitor
+
+SOURCES += \
+    $$SRC_DIR/Utils/hotplugmonitor.cpp \
+    tst_hotplugmonitor.cpp
+
+HEADERS += \
+    $$SRC_DIR/Utils/hotplugmonitor.h
@@ -0,0 +1,107 @@
+#include "hotplugmonitor.h"
+
+#include <QFile>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <memory>
+
+// Plays udev in a temporary directory: creates and removes hidrawN files where the
+// monitor expects /dev
+class TestHotplugMonitor : public QObject
+{
+    Q_OBJECT
+
+private:
+    // HotplugMonitor waits this long after the last change before it compares nodes
+    static constexpr int MSEC_SETTLE_DELAY = 500;
+
+    std::unique_ptr<QTemporaryDir> dir;
+    std::unique_ptr<HotplugMonitor> monitor;
+
+    bool touch(const QString &name);
+
+private slots:
+    void init();
+    void cleanup();
+
+    void readsRootFromEnvironment();
+    void signalsOncePerBurst();
+    void signalsRemoval();
+    void ignoresOtherFiles();
+};
+
+void TestHotplugMonitor::init()
+{
+    dir = std::make_unique<QTemporaryDir>();
+    QVERIFY(dir->isValid());
+    QVERIFY(touch("hidraw0"));
+    monitor = std::make_unique<HotplugMonitor>(dir->path());
+    if (!monitor->isAvailable()) {
+        QSKIP("hidraw hotplug is only watched on Linux");
+    }
+}
+
+void TestHotplugMonitor::cleanup()
+{
+    monitor.reset();
+    dir.reset();
+}
+
+bool TestHotplugMonitor::touch(const QString &name)
+{
+    QFile file(dir->filePath(name));
+    return file.open(QIODevice::WriteOnly);
+}
+
+void TestHotplugMonitor::readsRootFromEnvironment()
+{
+    qputenv("HEADSETCONTROL_GUI_HOTPLUG_ROOT", dir->path().toLocal8Bit());
+    QCOMPARE(HotplugMonitor::defaultWatchRoot(), dir->path());
+    qunsetenv("HEADSETCONTROL_GUI_HOTPLUG_ROOT");
+    QCOMPARE(HotplugMonitor::defaultWatchRoot(), QString("/dev"));
+}
+
+void TestHotplugMonitor::signalsOncePerBurst()
+{
+    QSignalSpy changed(monitor.get(), &HotplugMonitor::devicesChanged);
+
+    // A dongle brings up its interfaces one after another
+    for (const QString &node : {"hidraw1", "hidraw2", "hidraw3"}) {
+        QVERIFY(touch(node));
+        QTest::qWait(MSEC_SETTLE_DELAY / 5);
+    }
+    QTRY_COMPARE_WITH_TIMEOUT(changed.count(), 1, 4 * MSEC_SETTLE_DELAY);
+    QTest::qWait(2 * MSEC_SETTLE_DELAY);
+    QCOMPARE(changed.count(), 1);
+
+    // The next plug is a burst of its own
+    QVERIFY(touch("hidraw4"));
+    QTRY_COMPARE_WITH_TIMEOUT(changed.count(), 2, 4 * MSEC_SETTLE_DELAY);
+}
+
+void TestHotplugMonitor::signalsRemoval()
+{
+    QSignalSpy changed(monitor.get(), &HotplugMonitor::devicesChanged);
+
+    QVERIFY(QFile::remove(dir->filePath("hidraw0")));
+    QTRY_COMPARE_WITH_TIMEOUT(changed.count(), 1, 4 * MSEC_SETTLE_DELAY);
+    QTest::qWait(2 * MSEC_SETTLE_DELAY);
+    QCOMPARE(changed.count(), 1);
+}
+
+void TestHotplugMonitor::ignoresOtherFiles()
+{
+    QSignalSpy changed(monitor.get(), &HotplugMonitor::devicesChanged);
+
+    // /dev sees far more than HID nodes come and go
+    QVERIFY(touch("ttyUSB0"));
+    QVERIFY(touch("input-event3"));
+    QVERIFY(QFile::remove(dir->filePath("ttyUSB0")));
+    QTest::qWait(3 * MSEC_SETTLE_DELAY);
+    QCOMPARE(changed.count(), 0);
+}
+
+QTEST_GUILESS_MAIN(TestHotplugMonitor)
+#include "tst_hotplugmonitor.moc"
@@ -0,0 +1,237 @@
+#include "inputreportlistener.h"
+
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <atomic>
+#include <memory>
+#include <unistd.h>
+
+// Feeds recorded Arctis Nova 7 reports to InputReportListener through a pipe, the
+// way its hidraw node would hand them over, and looks its node up in a fake sysfs
+class TestInputReportListener : public QObject
+{
+    Q_OBJECT
+
+private:
+    static constexpr int REPORT_SIZE = 64;
+    // Times the recording is replayed per benchmark iteration; stays well below the pipe buffer
+    static constexpr int REPLAYS = 16;
+
+    const ReportDecoder *decoder = nullptr;
+    QList<QByteArray> reports;
+    int decodable = 0;
+
+    std::unique_ptr<InputReportListener> listener;
+    int writeFd = -1;
+
+    bool startPipe();
+    void feed();
+
+    // Lays out sysfsRoot/<node>/device/{uevent,report_descriptor} as the kernel does
+    static bool addNode(const QString &sysfsRoot,
+                        const QString &node,
+                        const QByteArray &hidId,
+                        const QByteArray &phys,
+                        const QByteArray &descriptor);
+
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void decodesRecordedReports();
+    void stopsWhenWriterCloses();
+    void findsNodeByInterface();
+    void findsNodeByUsagePage();
+
+    void benchmarkDecodeOverPipe();
+};
+
+void TestInputReportListener::initTestCase()
+{
+    decoder = ReportDecoder::find(0x1038, 0x2202);
+    QVERIFY(decoder != nullptr);
+
+    QFile file(QFINDTESTDATA("../data/arctis_nova7_reports.txt"));
+    QVERIFY(file.open(QIODevice::ReadOnly | QIODevice::Text));
+    while (!file.atEnd()) {
+        QByteArray line = file.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+        // One report per read only holds if every write is a whole report
+        QByteArray report = QByteArray::fromHex(line).leftJustified(REPORT_SIZE, '\0');
+        ReportUpdate update;
+        if (decoder->decode(report, update)) {
+            decodable++;
+        }
+        reports.append(report);
+    }
+    QCOMPARE(decodable, 12);
+}
+
+void TestInputReportListener::init()
+{
+    listener = std::make_unique<InputReportListener>();
+}
+
+void TestInputReportListener::cleanup()
+{
+    listener.reset();
+    if (writeFd >= 0) {
+        ::close(writeFd);
+        writeFd = -1;
+    }
+    // Updates still queued to this thread would reach handlers of a test that has returned
+    QCoreApplication::removePostedEvents(this, QEvent::MetaCall);
+}
+
+bool TestInputReportListener::startPipe()
+{
+    int fds[2];
+    if (::pipe(fds) != 0) {
+        return false;
+    }
+    writeFd = fds[1];
+    // Takes ownership of the read end
+    return listener->start(fds[0], decoder);
+}
+
+void TestInputReportListener::feed()
+{
+    for (const QByteArray &report : std::as_const(reports)) {
+        QVERIFY(::write(writeFd, report.constData(), report.size()) == report.size());
+    }
+}
+
+void TestInputReportListener::decodesRecordedReports()
+{
+    QList<ReportUpdate> updates;
+    connect(listener.get(),
+            &InputReportListener::reportDecoded,
+            this,
+            [&](const ReportUpdate &update) { updates.append(update); });
+    QVERIFY(startPipe());
+
+    feed();
+    QTRY_COMPARE(updates.size(), decodable);
+
+    // The dial sweep, from all game through balanced to all chat
+    QVERIFY(updates.first().has_chatmix);
+    QCOMPARE(updates.at(0).chatmix, 0);
+    QCOMPARE(updates.at(4).chatmix, 64);
+    QCOMPARE(updates.at(8).chatmix, 128);
+
+    QVERIFY(updates.at(9).has_battery);
+    QVERIFY(!updates.at(9).has_chatmix);
+    QCOMPARE(updates.at(9).battery.status, QString("BATTERY_AVAILABLE"));
+    QCOMPARE(updates.at(9).battery.level, 100);
+    QCOMPARE(updates.at(10).battery.status, QString("BATTERY_CHARGING"));
+    QCOMPARE(updates.at(10).battery.level, 50);
+    QCOMPARE(updates.at(11).battery.status, QString("BATTERY_UNAVAILABLE"));
+}
+
+void TestInputReportListener::stopsWhenWriterCloses()
+{
+    QVERIFY(startPipe());
+    QVERIFY(listener->isRunning());
+
+    // Same as the headset being unplugged
+    ::close(writeFd);
+    writeFd = -1;
+    QTRY_VERIFY(!listener->isRunning());
+}
+
+bool TestInputReportListener::addNode(const QString &sysfsRoot,
+                                      const QString &node,
+                                      const QByteArray &hidId,
+                                      const QByteArray &phys,
+                                      const QByteArray &descriptor)
+{
+    QDir device(sysfsRoot + "/" + node + "/device");
+    if (!device.mkpath(".")) {
+        return false;
+    }
+    QFile uevent(device.filePath("uevent"));
+    QFile report(device.filePath("report_descriptor"));
+    QByteArray content = "DRIVER=hid-generic\nHID_ID=" + hidId + "\nHID_NAME=Arctis Nova 7\n";
+    if (!phys.isEmpty()) {
+        content += "HID_PHYS=" + phys + "\n";
+    }
+    return uevent.open(QIODevice::WriteOnly) && uevent.write(content) == content.size()
+           && report.open(QIODevice::WriteOnly) && report.write(descriptor) == descriptor.size();
+}
+
+// Usage Page (Vendor 0xffc0), Usage (1), Collection (Application)
+static const QByteArray VENDOR_DESCRIPTOR = QByteArray::fromHex("06c0ff0901a101");
+// Usage Page (Consumer), Usage (Consumer Control), Collection (Application)
+static const QByteArray CONSUMER_DESCRIPTOR = QByteArray::fromHex("050c0901a101");
+
+void TestInputReportListener::findsNodeByInterface()
+{
+    QTemporaryDir sysfs;
+    QVERIFY(sysfs.isValid());
+    const QString root = sysfs.path();
+    const QByteArray nova7 = "0003:00001038:00002202";
+    const QByteArray port = "usb-0000:00:14.0-2";
+    // The dongle's interfaces, listed by name as hidraw10, hidraw2, hidraw3
+    QVERIFY(addNode(root, "hidraw2", nova7, port + "/input0", CONSUMER_DESCRIPTOR));
+    QVERIFY(addNode(root, "hidraw3", nova7, port + "/input4", VENDOR_DESCRIPTOR));
+    QVERIFY(addNode(root, "hidraw10", nova7, port + "/input3", VENDOR_DESCRIPTOR));
+    // Another headset on the interface number we want
+    QVERIFY(addNode(root,
+                    "hidraw1",
+                    "0003:00001038:000012AD",
+                    "usb-0000:00:14.0-1/input3",
+                    VENDOR_DESCRIPTOR));
+
+    QCOMPARE(InputReportListener::findHidrawNode(*decoder, root), QString("/dev/hidraw10"));
+
+    // Without the reporting interface there is nothing to listen to
+    QVERIFY(QDir(sysfs.filePath("hidraw10")).removeRecursively());
+    QVERIFY(InputReportListener::findHidrawNode(*decoder, root).isEmpty());
+}
+
+void TestInputReportListener::findsNodeByUsagePage()
+{
+    QTemporaryDir sysfs;
+    QVERIFY(sysfs.isValid());
+    const QString root = sysfs.path();
+    const QByteArray nova7 = "0005:00001038:00002202";
+    // No interface in HID_PHYS, as over Bluetooth
+    QVERIFY(addNode(root, "hidraw2", nova7, "", CONSUMER_DESCRIPTOR));
+    QVERIFY(addNode(root, "hidraw10", nova7, "", VENDOR_DESCRIPTOR));
+    QVERIFY(addNode(root, "hidraw9", nova7, "", VENDOR_DESCRIPTOR));
+
+    // Numeric order: hidraw9 comes before hidraw10
+    QCOMPARE(InputReportListener::findHidrawNode(*decoder, root), QString("/dev/hidraw9"));
+}
+
+void TestInputReportListener::benchmarkDecodeOverPipe()
+{
+    // Counted on the reader thread, so the event loop stays out of the measurement
+    std::atomic<int> decoded{0};
+    connect(
+        listener.get(),
+        &InputReportListener::reportDecoded,
+        this,
+        [&decoded]() { decoded++; },
+        Qt::DirectConnection);
+    QVERIFY(startPipe());
+
+    QBENCHMARK {
+        const int target = decoded + REPLAYS * decodable;
+        for (int i = 0; i < REPLAYS; ++i) {
+            feed();
+        }
+        while (decoded < target) {
+            QThread::yieldCurrentThread();
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(TestInputReportListener)
+#include "tst_inputreportlistener.moc"
@@ -0,0 +1,115 @@
+#include "pollscheduler.h"
+
+#include <QTest>
+
+static constexpr int MSEC_MIN = 5000;
+static constexpr int MSEC_DEFAULT = 30000;
+static constexpr int MSEC_MAX = 120000;
+static constexpr qint64 MINUTE = 60 * 1000;
+
+static Device makeDevice(const QString &status, int level)
+{
+    Device device;
+    device.battery = Battery(status, level);
+    return device;
+}
+
+class TestPollScheduler : public QObject
+{
+    Q_OBJECT
+
+private:
+    PollScheduler scheduler;
+
+private slots:
+    void init();
+
+    void pollsFastWhileCharging();
+    void pollsFastWhenLow();
+    void keepsDefaultWhileDraining();
+    void slowsDownWhenStable();
+    void slowsDownWhenOff();
+    void backsOffWithoutDevice();
+};
+
+void TestPollScheduler::init()
+{
+    scheduler = PollScheduler();
+    scheduler.setIntervals(MSEC_MIN, MSEC_DEFAULT, MSEC_MAX);
+    scheduler.setBatteryLowThreshold(15);
+}
+
+void TestPollScheduler::pollsFastWhileCharging()
+{
+    Device device = makeDevice("BATTERY_CHARGING", 60);
+    QCOMPARE(scheduler.nextInterval(&device, true, 0), MSEC_MIN);
+    QCOMPARE(scheduler.nextInterval(&device, true, 60 * MINUTE), MSEC_MIN);
+
+    // Nothing left to follow once it is full
+    device.battery.level = 100;
+    QCOMPARE(scheduler.nextInterval(&device, true, 61 * MINUTE), MSEC_MAX);
+}
+
+void TestPollScheduler::pollsFastWhenLow()
+{
+    // Within the margin above the threshold, so the warning comes in time
+    Device device = makeDevice("BATTERY_AVAILABLE", 20);
+    QCOMPARE(scheduler.nextInterval(&device, true, 0), MSEC_MIN);
+    QCOMPARE(scheduler.nextInterval(&device, true, 60 * MINUTE), MSEC_MIN);
+
+    device.battery.level = 21;
+    QCOMPARE(scheduler.nextInterval(&device, true, 61 * MINUTE), MSEC_DEFAULT);
+}
+
+void TestPollScheduler::keepsDefaultWhileDraining()
+{
+    // 1% every 4 minutes, polled at the default interval: most polls see no change
+    Device device = makeDevice("BATTERY_AVAILABLE", 80);
+    for (qint64 msec = 0; msec < 120 * MINUTE; msec += MSEC_DEFAULT) {
+        device.battery.level = 80 - int(msec / (4 * MINUTE));
+        QCOMPARE(scheduler.nextInterval(&device, true, msec), MSEC_DEFAULT);
+    }
+}
+
+void TestPollScheduler::slowsDownWhenStable()
+{
+    Device device = makeDevice("BATTERY_AVAILABLE", 75);
+    QCOMPARE(scheduler.nextInterval(&device, true, 0), MSEC_DEFAULT);
+    QCOMPARE(scheduler.nextInterval(&device, true, 19 * MINUTE), MSEC_DEFAULT);
+    QCOMPARE(scheduler.nextInterval(&device, true, 20 * MINUTE), MSEC_MAX);
+
+    // Any change starts over
+    device.battery.level = 74;
+    QCOMPARE(scheduler.nextInterval(&device, true, 22 * MINUTE), MSEC_DEFAULT);
+
+    // So does a device that was lost and found again
+    QCOMPARE(scheduler.nextInterval(&device, true, 45 * MINUTE), MSEC_MAX);
+    scheduler.reset();
+    QCOMPARE(scheduler.nextInterval(&device, true, 46 * MINUTE), MSEC_DEFAULT);
+}
+
+void TestPollScheduler::slowsDownWhenOff()
+{
+    Device device = makeDevice("BATTERY_UNAVAILABLE", -1);
+    QCOMPARE(scheduler.nextInterval(&device, true, 0), MSEC_MAX);
+}
+
+void TestPollScheduler::backsOffWithoutDevice()
+{
+    QCOMPARE(scheduler.nextInterval(nullptr, false, 0), MSEC_DEFAULT);
+    QCOMPARE(scheduler.nextInterval(nullptr, false, 0), 2 * MSEC_DEFAULT);
+    QCOMPARE(scheduler.nextInterval(nullptr, false, 0), MSEC_MAX);
+    QCOMPARE(scheduler.nextInterval(nullptr, false, 0), MSEC_MAX);
+
+    // Devices present but none selected: back to the default right away
+    QCOMPARE(scheduler.nextInterval(nullptr, true, 0), MSEC_DEFAULT);
+    QCOMPARE(scheduler.nextInterval(nullptr, false, 0), MSEC_DEFAULT);
+
+    // As after a hotplug event
+    QCOMPARE(scheduler.nextInterval(nullptr, false, 0), 2 * MSEC_DEFAULT);
+    scheduler.reset();
+    QCOMPARE(scheduler.nextInterval(nullptr, false, 0), MSEC_DEFAULT);
+}
+
+QTEST_GUILESS_MAIN(TestPollScheduler)
+#include "tst_pollscheduler.moc"
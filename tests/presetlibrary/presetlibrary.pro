@@ -0,0 +1,20 @@
+include(../tests.pri)
+
+QT += concurrent
+
+TARGET = tst_presetlibrary
+
+SOURCES += \
+    $$SRC_DIR/DataTypes/configfile.cpp \
+    $$SRC_DIR/DataTypes/device.cpp \
+    $$SRC_DIR/DataTypes/deviceregistry.cpp \
+    $$SRC_DIR/Utils/equalizerfit.cpp \
+    $$SRC_DIR/Utils/presetlibrary.cpp \
+    tst_presetlibrary.cpp
+
+HEADERS += \
+    $$SRC_DIR/DataTypes/configfile.h \
+    $$SRC_DIR/DataTypes/device.h \
+    $$SRC_DIR/DataTypes/deviceregistry.h \
+    $$SRC_DIR/Utils/equalizerfit.h \
+    $$SRC_DIR/Utils/presetlibrary.h
@@ -0,0 +1,268 @@
+#include "presetlibrary.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QtConcurrent/QtConcurrent>
+
+#include <memory>
+
+static bool writeFile(const QString &filePath, const QByteArray &content)
+{
+    QDir().mkpath(QFileInfo(filePath).path());
+    QFile file(filePath);
+    return file.open(QIODevice::WriteOnly) && file.write(content) == content.size();
+}
+
+// What search() would cost without the index: walk the tree and match every
+// model and name, before even looking at what the files hold
+static int scanDirectory(const QString &root, const QString &prefix, int limit)
+{
+    const QString needle = prefix.trimmed().toCaseFolded();
+    int matches = 0;
+    QDirIterator it(root,
+                    QStringList() << "*.txt" << "*.csv",
+                    QDir::Files,
+                    QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        QFileInfo info = it.fileInfo();
+        if (info.dir().dirName().toCaseFolded().startsWith(needle)
+            || info.completeBaseName().toCaseFolded().startsWith(needle)) {
+            matches++;
+        }
+    }
+    return qMin(matches, limit);
+}
+
+class TestPresetLibrary : public QObject
+{
+    Q_OBJECT
+
+private:
+    // Roughly the size of AutoEQ's results folder
+    static constexpr int MODELS = 2500;
+
+    std::unique_ptr<QTemporaryDir> dir;
+    QTemporaryDir benchmarkDir;
+    std::unique_ptr<PresetLibrary> benchmarkLibrary;
+
+    QString presetsRoot() const;
+    QString indexFilePath() const;
+
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void findsByModelOrName();
+    void servesOldIndexUntilPublished();
+    void rereadsOnlyChangedFiles();
+    void loadsEqualizationColumn_data();
+    void loadsEqualizationColumn();
+
+    void benchmarkIndexLookup_data();
+    void benchmarkIndexLookup();
+    void benchmarkFullScan_data();
+    void benchmarkFullScan();
+};
+
+void TestPresetLibrary::initTestCase()
+{
+    QVERIFY(benchmarkDir.isValid());
+    const QStringList brands = {"Audio-Technica", "Beyerdynamic", "Sennheiser", "Sony", "Koss"};
+    const QString root = benchmarkDir.filePath("presets");
+    for (int i = 0; i < MODELS; ++i) {
+        QString model = brands.at(i % brands.size()) + " HD " + QString::number(i);
+        QString modelDir = root + "/" + model + "/" + model;
+        QVERIFY(writeFile(modelDir + " GraphicEQ.txt", "GraphicEQ: 20 -1.0; 1000 0.0\n"));
+        QVERIFY(writeFile(modelDir + " ParametricEQ.txt",
+                          "Filter 1: ON PK Fc 105 Hz Gain -2.5 dB Q 0.70\n"));
+    }
+    benchmarkLibrary = std::make_unique<PresetLibrary>(benchmarkDir.filePath("presets.idx"));
+    QVERIFY(benchmarkLibrary->scan(root));
+    QCOMPARE(benchmarkLibrary->size(), 2 * MODELS);
+}
+
+void TestPresetLibrary::init()
+{
+    dir = std::make_unique<QTemporaryDir>();
+    QVERIFY(dir->isValid());
+    QVERIFY(writeFile(presetsRoot() + "/Sennheiser HD 600/Sennheiser HD 600 GraphicEQ.txt",
+                      "GraphicEQ: 20 -1.0; 1000 0.0\n"));
+    QVERIFY(writeFile(presetsRoot() + "/Sennheiser HD 650/Sennheiser HD 650 ParametricEQ.txt",
+                      "Preamp: -6.0 dB\nFilter 1: ON PK Fc 105 Hz Gain -2.5 dB Q 0.70\n"));
+    QVERIFY(writeFile(presetsRoot() + "/Sony WH-1000XM4/Sony WH-1000XM4.csv",
+                      "frequency,raw,equalization\n20,1.0,-2.0\n"));
+    QVERIFY(writeFile(presetsRoot() + "/Sony WH-1000XM4/README.txt", "Measured by oratory1990\n"));
+}
+
+void TestPresetLibrary::cleanup()
+{
+    dir.reset();
+}
+
+QString TestPresetLibrary::presetsRoot() const
+{
+    return dir->filePath("presets");
+}
+
+QString TestPresetLibrary::indexFilePath() const
+{
+    return dir->filePath("presets.idx");
+}
+
+void TestPresetLibrary::findsByModelOrName()
+{
+    PresetLibrary library(indexFilePath());
+    QVERIFY(library.getRoot().isEmpty());
+    QVERIFY(library.scan(presetsRoot()));
+
+    // The README is indexed but never found
+    QCOMPARE(library.size(), 4);
+    QCOMPARE(library.search("sennheiser").size(), 2);
+    QVERIFY(library.search("readme").isEmpty());
+
+    QList<PresetLibrary::Entry> sony = library.search("SONY");
+    QCOMPARE(sony.size(), 1);
+    QCOMPARE(sony.first().model, QString("Sony WH-1000XM4"));
+    QCOMPARE(sony.first().format, PresetLibrary::Csv);
+
+    QList<PresetLibrary::Entry> parametric = library.search("sennheiser hd 650 para");
+    QCOMPARE(parametric.size(), 1);
+    QCOMPARE(parametric.first().format, PresetLibrary::Parametric);
+    QVERIFY(QFile::exists(parametric.first().filePath));
+}
+
+void TestPresetLibrary::servesOldIndexUntilPublished()
+{
+    PresetLibrary library(indexFilePath());
+    QVERIFY(library.scan(presetsRoot()));
+    QVERIFY(writeFile(presetsRoot() + "/Sony WH-1000XM5/Sony WH-1000XM5 GraphicEQ.txt",
+                      "GraphicEQ: 20 -1.0; 1000 0.0\n"));
+
+    // As PresetLibraryWindow does it
+    const QString root = presetsRoot();
+    QFuture<bool> built = QtConcurrent::run([&library, root]() { return library.build(root); });
+    qsizetype duringBuild = library.search("sony").size();
+    QVERIFY(built.result());
+    QCOMPARE(duringBuild, 1);
+    QCOMPARE(library.search("sony").size(), 1);
+
+    QVERIFY(library.publish());
+    QCOMPARE(library.search("sony").size(), 2);
+    QCOMPARE(library.size(), 5);
+
+    // The next start opens what was published
+    PresetLibrary reopened(indexFilePath());
+    QCOMPARE(reopened.getRoot(), QDir::cleanPath(presetsRoot()));
+    QCOMPARE(reopened.search("sony").size(), 2);
+}
+
+void TestPresetLibrary::rereadsOnlyChangedFiles()
+{
+    PresetLibrary library(indexFilePath());
+    int reread = -1;
+    QVERIFY(library.scan(presetsRoot(), &reread));
+    QCOMPARE(reread, 4);
+    QVERIFY(library.scan(presetsRoot(), &reread));
+    QCOMPARE(reread, 0);
+
+    // Pushed well past the first scan, whatever the file system's time resolution
+    const QString changed = presetsRoot() + "/Sennheiser HD 600/Sennheiser HD 600 GraphicEQ.txt";
+    QVERIFY(writeFile(changed, "GraphicEQ: 20 -2.0; 1000 0.0\n"));
+    QFile file(changed);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.setFileTime(QDateTime::currentDateTime().addSecs(3600),
+                             QFileDevice::FileModificationTime));
+    file.close();
+
+    QVERIFY(library.scan(presetsRoot(), &reread));
+    QCOMPARE(reread, 1);
+    QCOMPARE(library.size(), 4);
+
+    // The next start picks up where the last scan left off
+    PresetLibrary reopened(indexFilePath());
+    QVERIFY(reopened.scan(presetsRoot(), &reread));
+    QCOMPARE(reread, 0);
+}
+
+void TestPresetLibrary::loadsEqualizationColumn_data()
+{
+    QTest::addColumn<QByteArray>("content");
+    QTest::addColumn<QList<double>>("gains");
+
+    QTest::newRow("AutoEQ") << QByteArray("frequency,raw,equalization\n20,1.0,-2.0\n1000,0.5,0\n")
+                            << QList<double>{-2.0, 0.0};
+    QTest::newRow("equalization first") << QByteArray("frequency,equalization,raw\n20,-2.0,1.0\n")
+                                        << QList<double>{-2.0};
+    QTest::newRow("pairs") << QByteArray("20,-2.0\n1000;0.0\n") << QList<double>{-2.0, 0.0};
+    // The measurement is no correction
+    QTest::newRow("raw only") << QByteArray("frequency,raw\n20,1.0\n") << QList<double>();
+    QTest::newRow("no header") << QByteArray("20,1.0,-2.0\n") << QList<double>();
+}
+
+void TestPresetLibrary::loadsEqualizationColumn()
+{
+    QFETCH(QByteArray, content);
+    QFETCH(QList<double>, gains);
+
+    PresetLibrary::Entry entry;
+    entry.filePath = dir->filePath("curve.csv");
+    entry.format = PresetLibrary::Csv;
+    QVERIFY(writeFile(entry.filePath, content));
+
+    QList<double> loaded;
+    for (const EqualizerFit::CurvePoint &point : PresetLibrary::loadPreset(entry)) {
+        loaded.append(point.gain);
+    }
+    QCOMPARE(loaded, gains);
+}
+
+static void addPrefixRows()
+{
+    QTest::addColumn<QString>("prefix");
+
+    // A fifth of the library, up to the result limit
+    QTest::newRow("broad") << QString("so");
+    QTest::newRow("one model") << QString("sony hd 1003");
+    QTest::newRow("no match") << QString("zz");
+}
+
+void TestPresetLibrary::benchmarkIndexLookup_data()
+{
+    addPrefixRows();
+}
+
+void TestPresetLibrary::benchmarkIndexLookup()
+{
+    QFETCH(QString, prefix);
+
+    int matches = 0;
+    QBENCHMARK {
+        matches = benchmarkLibrary->search(prefix).size();
+    }
+    QCOMPARE(matches, scanDirectory(benchmarkLibrary->getRoot(), prefix, 200));
+}
+
+void TestPresetLibrary::benchmarkFullScan_data()
+{
+    addPrefixRows();
+}
+
+void TestPresetLibrary::benchmarkFullScan()
+{
+    QFETCH(QString, prefix);
+
+    int matches = 0;
+    QBENCHMARK {
+        matches = scanDirectory(benchmarkLibrary->getRoot(), prefix, 200);
+    }
+    QCOMPARE(matches, benchmarkLibrary->search(prefix).size());
+}
+
+QTEST_GUILESS_MAIN(TestPresetLibrary)
+#include "tst_presetlibrary.moc"
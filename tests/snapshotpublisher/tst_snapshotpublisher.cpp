@@ -0,0 +1,205 @@
+#include "device.h"
+#include "snapshotpublisher.h"
+
+#include <QMutex>
+#include <QTest>
+#include <QThread>
+
+#include <atomic>
+#include <memory>
+
+// The straightforward alternative the benchmarks compare against: one mutex
+// shared by the readers and the writer
+class LockedState
+{
+public:
+    std::shared_ptr<const DeviceState> load() const
+    {
+        QMutexLocker locker(&mutex);
+        return current;
+    }
+
+    void publish(DeviceState state)
+    {
+        auto snapshot = std::make_shared<const DeviceState>(std::move(state));
+        QMutexLocker locker(&mutex);
+        current = std::move(snapshot);
+    }
+
+private:
+    mutable QMutex mutex;
+    std::shared_ptr<const DeviceState> current = std::make_shared<const DeviceState>();
+};
+
+// Two headsets, with values derived from the sequence so a torn read would show
+static DeviceState makeState(quint64 sequence)
+{
+    DeviceState state;
+    state.sequence = sequence;
+    for (int i = 0; i < 2; ++i) {
+        DeviceStatus status;
+        status.id_vendor = "0x1038";
+        status.id_product = "0x2202";
+        status.status = "SUCCESS";
+        status.has_battery = true;
+        status.battery = Battery("BATTERY_AVAILABLE", int(sequence % 100));
+        status.has_chatmix = true;
+        status.chatmix = int(sequence % 128);
+        state.statuses.append(status);
+    }
+    return state;
+}
+
+// Publishes one new state after another until running goes false; returns once the
+// first one is out
+template<typename Publisher>
+static std::unique_ptr<QThread> startWriter(Publisher &publisher, std::atomic<bool> &running)
+{
+    running = true;
+    std::unique_ptr<QThread> writer(QThread::create([&publisher, &running]() {
+        quint64 sequence = 0;
+        while (running) {
+            publisher.publish(makeState(++sequence));
+        }
+    }));
+    writer->start();
+    // Readers should never see only the initial empty state
+    while (publisher.load()->sequence == 0) {
+        QThread::yieldCurrentThread();
+    }
+    return writer;
+}
+
+static bool isConsistent(const DeviceState &state)
+{
+    if (state.sequence == 0) {
+        return state.statuses.isEmpty();
+    }
+    return state.statuses.size() == 2
+           && state.statuses.last().battery.level == int(state.sequence % 100)
+           && state.statuses.last().chatmix == int(state.sequence % 128);
+}
+
+class TestSnapshotPublisher : public QObject
+{
+    Q_OBJECT
+
+private:
+    // Loads per benchmark iteration, so a single one is long enough to time
+    static constexpr int READS = 1000;
+
+private slots:
+    void isLockFree();
+    void publishesWholeSnapshots();
+    void keepsLoadedSnapshotAlive();
+    void readsConsistentSnapshotsUnderWriter();
+
+    void benchmarkReads();
+    void benchmarkReadsWithWriter();
+    void benchmarkLockedReadsWithWriter();
+};
+
+void TestSnapshotPublisher::isLockFree()
+{
+    // Readers on the GUI thread must never wait for the API thread
+    SnapshotPublisher<DeviceState> publisher;
+    QVERIFY(publisher.isLockFree());
+}
+
+void TestSnapshotPublisher::publishesWholeSnapshots()
+{
+    SnapshotPublisher<DeviceState> publisher;
+    QCOMPARE(publisher.load()->sequence, quint64(0));
+    QVERIFY(publisher.load()->statuses.isEmpty());
+
+    publisher.publish(makeState(7));
+    std::shared_ptr<const DeviceState> state = publisher.load();
+    QCOMPARE(state->sequence, quint64(7));
+    QVERIFY(isConsistent(*state));
+}
+
+void TestSnapshotPublisher::keepsLoadedSnapshotAlive()
+{
+    SnapshotPublisher<DeviceState> publisher;
+    publisher.publish(makeState(1));
+    std::shared_ptr<const DeviceState> held = publisher.load();
+
+    publisher.publish(makeState(2));
+    QCOMPARE(held->sequence, quint64(1));
+    QCOMPARE(held->statuses.size(), 2);
+    QCOMPARE(held.use_count(), 1);
+    QCOMPARE(publisher.load()->sequence, quint64(2));
+}
+
+void TestSnapshotPublisher::readsConsistentSnapshotsUnderWriter()
+{
+    SnapshotPublisher<DeviceState> publisher;
+    std::atomic<bool> running;
+    std::unique_ptr<QThread> writer = startWriter(publisher, running);
+
+    quint64 lastSequence = 0;
+    bool consistent = true;
+    for (int i = 0; i < 100 * READS; ++i) {
+        std::shared_ptr<const DeviceState> state = publisher.load();
+        consistent = consistent && state->sequence >= lastSequence && isConsistent(*state);
+        lastSequence = state->sequence;
+    }
+
+    running = false;
+    writer->wait();
+    QVERIFY(consistent);
+    QVERIFY(lastSequence > 0);
+}
+
+void TestSnapshotPublisher::benchmarkReads()
+{
+    SnapshotPublisher<DeviceState> publisher;
+    publisher.publish(makeState(1));
+
+    quint64 sum = 0;
+    QBENCHMARK {
+        for (int i = 0; i < READS; ++i) {
+            sum += publisher.load()->sequence;
+        }
+    }
+    QVERIFY(sum > 0);
+}
+
+void TestSnapshotPublisher::benchmarkReadsWithWriter()
+{
+    SnapshotPublisher<DeviceState> publisher;
+    std::atomic<bool> running;
+    std::unique_ptr<QThread> writer = startWriter(publisher, running);
+
+    quint64 sum = 0;
+    QBENCHMARK {
+        for (int i = 0; i < READS; ++i) {
+            sum += publisher.load()->sequence;
+        }
+    }
+
+    running = false;
+    writer->wait();
+    QVERIFY(sum > 0);
+}
+
+void TestSnapshotPublisher::benchmarkLockedReadsWithWriter()
+{
+    LockedState locked;
+    std::atomic<bool> running;
+    std::unique_ptr<QThread> writer = startWriter(locked, running);
+
+    quint64 sum = 0;
+    QBENCHMARK {
+        for (int i = 0; i < READS; ++i) {
+            sum += locked.load()->sequence;
+        }
+    }
+
+    running = false;
+    writer->wait();
+    QVERIFY(sum > 0);
+}
+
+QTEST_GUILESS_MAIN(TestSnapshotPublisher)
+#include "tst_snapshotpublisher.moc"
@@ -0,0 +1,11 @@
+QT += testlib
+QT -= gui
+
+CONFIG += c++17 console testcase
+CONFIG -= app_bundle
+
+SRC_DIR = $$PWD/../src
+
+INCLUDEPATH += \
+    $$SRC_DIR/DataTypes \
+    $$SRC_DIR/Utils
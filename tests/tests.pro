@@ -0,0 +1,18 @@
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    apithread \
+    deviceregistry \
+    devicesettingsstore \
+    equalizerfit \
+    equalizersliders \
+    headsetcontrolapi \
+    headsetcontrolparser \
+    hotplugmonitor \
+    pollscheduler \
+    presetlibrary \
+    snapshotpublisher \
+    updatechecker
+
+# Feed their input through a pipe
+unix: SUBDIRS += headsetcontrolstream inputreportlistener
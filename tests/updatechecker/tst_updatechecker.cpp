@@ -0,0 +1,194 @@
+#include "updatechecker.h"
+
+#include <QHash>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <memory>
+
+// Stands in for GitHub's releases endpoint: the release with its ETag, or a bodiless
+// 304 when the request's If-None-Match still matches
+class ReleasesServer : public QTcpServer
+{
+public:
+    QByteArray tag = "v3.1.0";
+    QByteArray etag = "\"release-1\"";
+    // Header block of every request received, in order
+    QList<QByteArray> requests;
+
+    ReleasesServer()
+    {
+        connect(this, &QTcpServer::newConnection, this, [this]() {
+            while (QTcpSocket *socket = nextPendingConnection()) {
+                connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { read(socket); });
+                connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+            }
+        });
+    }
+
+    static QByteArray header(const QByteArray &request, const QByteArray &name)
+    {
+        for (const QByteArray &line : request.split('\n')) {
+            int colon = line.indexOf(':');
+            if (colon > 0 && line.left(colon).trimmed().toLower() == name.toLower()) {
+                return line.mid(colon + 1).trimmed();
+            }
+        }
+        return QByteArray();
+    }
+
+private:
+    QHash<QTcpSocket *, QByteArray> buffers;
+
+    void read(QTcpSocket *socket)
+    {
+        QByteArray &buffer = buffers[socket];
+        buffer += socket->readAll();
+        int end = buffer.indexOf("\r\n\r\n");
+        if (end < 0) {
+            return;
+        }
+        QByteArray request = buffer.left(end);
+        buffers.remove(socket);
+        requests.append(request);
+
+        QByteArray response;
+        if (header(request, "If-None-Match") == etag) {
+            response = "HTTP/1.1 304 Not Modified\r\nETag: " + etag
+                       + "\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        } else {
+            QByteArray body = "{\"tag_name\": \"" + tag + "\"}";
+            response = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nETag: " + etag
+                       + "\r\nContent-Length: " + QByteArray::number(body.size())
+                       + "\r\nConnection: close\r\n\r\n" + body;
+        }
+        socket->write(response);
+        socket->disconnectFromHost();
+    }
+};
+
+class TestUpdateChecker : public QObject
+{
+    Q_OBJECT
+
+private:
+    std::unique_ptr<ReleasesServer> server;
+    std::unique_ptr<QTemporaryDir> cacheDir;
+
+    QString cacheFilePath() const;
+    // Waits for the lookup and returns its version
+    static QString waitFor(QFuture<QString> future);
+
+private slots:
+    void init();
+    void cleanup();
+
+    void fetchesLatestRelease();
+    void revalidatesWithETag();
+    void skipsNetworkWithinTtl();
+    void keepsCacheAcrossRuns();
+};
+
+void TestUpdateChecker::init()
+{
+    server = std::make_unique<ReleasesServer>();
+    QVERIFY(server->listen(QHostAddress::LocalHost));
+    cacheDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(cacheDir->isValid());
+
+    // What UpdateChecker's default URL picks up, as a user would set it
+    qputenv("HEADSETCONTROL_GUI_RELEASES_API",
+            "http://127.0.0.1:" + QByteArray::number(server->serverPort()));
+}
+
+void TestUpdateChecker::cleanup()
+{
+    qunsetenv("HEADSETCONTROL_GUI_RELEASES_API");
+    server.reset();
+    cacheDir.reset();
+}
+
+QString TestUpdateChecker::cacheFilePath() const
+{
+    return cacheDir->filePath("update_cache.json");
+}
+
+QString TestUpdateChecker::waitFor(QFuture<QString> future)
+{
+    if (!QTest::qWaitFor([&future]() { return future.isFinished(); })) {
+        return QString("timed out");
+    }
+    return future.result();
+}
+
+void TestUpdateChecker::fetchesLatestRelease()
+{
+    UpdateChecker checker(cacheFilePath());
+
+    QCOMPARE(waitFor(checker.latestVersion("Sapd", "HeadsetControl")), QString("3.1.0"));
+    QCOMPARE(server->requests.size(), 1);
+    QVERIFY(server->requests.first().startsWith(
+        "GET /repos/Sapd/HeadsetControl/releases/latest "));
+    QVERIFY(ReleasesServer::header(server->requests.first(), "If-None-Match").isEmpty());
+}
+
+void TestUpdateChecker::revalidatesWithETag()
+{
+    UpdateChecker checker(cacheFilePath());
+    // Every lookup goes to the network
+    checker.setTtl(0);
+
+    QCOMPARE(waitFor(checker.latestVersion("Sapd", "HeadsetControl")), QString("3.1.0"));
+    QCOMPARE(waitFor(checker.latestVersion("Sapd", "HeadsetControl")), QString("3.1.0"));
+
+    // The second request carried the ETag and got a 304 without a body: the version
+    // above can only have come from the cache
+    QCOMPARE(server->requests.size(), 2);
+    QCOMPARE(ReleasesServer::header(server->requests.at(1), "If-None-Match"), server->etag);
+
+    // A new release changes the ETag, and the body is read again
+    server->tag = "v3.2.0";
+    server->etag = "\"release-2\"";
+    QCOMPARE(waitFor(checker.latestVersion("Sapd", "HeadsetControl")), QString("3.2.0"));
+}
+
+void TestUpdateChecker::skipsNetworkWithinTtl()
+{
+    UpdateChecker checker(cacheFilePath());
+
+    QCOMPARE(waitFor(checker.latestVersion("Sapd", "HeadsetControl")), QString("3.1.0"));
+    QCOMPARE(server->requests.size(), 1);
+
+    // Within the default 6 h the answer is ready before returning, without a request
+    QFuture<QString> cached = checker.latestVersion("Sapd", "HeadsetControl");
+    QVERIFY(cached.isFinished());
+    QCOMPARE(cached.result(), QString("3.1.0"));
+    QTest::qWait(50);
+    QCOMPARE(server->requests.size(), 1);
+}
+
+void TestUpdateChecker::keepsCacheAcrossRuns()
+{
+    {
+        UpdateChecker checker(cacheFilePath());
+        QCOMPARE(waitFor(checker.latestVersion("Sapd", "HeadsetControl")), QString("3.1.0"));
+    }
+
+    // Next start: the answer comes from the file
+    UpdateChecker checker(cacheFilePath());
+    QFuture<QString> cached = checker.latestVersion("Sapd", "HeadsetControl");
+    QVERIFY(cached.isFinished());
+    QCOMPARE(cached.result(), QString("3.1.0"));
+    QCOMPARE(server->requests.size(), 1);
+
+    // Once the TTL is over it revalidates with the ETag it saved
+    checker.setTtl(0);
+    QCOMPARE(waitFor(checker.latestVersion("Sapd", "HeadsetControl")), QString("3.1.0"));
+    QCOMPARE(server->requests.size(), 2);
+    QCOMPARE(ReleasesServer::header(server->requests.at(1), "If-None-Match"), server->etag);
+}
+
+QTEST_GUILESS_MAIN(TestUpdateChecker)
+#include "tst_updatechecker.moc"
@@ -0,0 +1,12 @@
+include(../tests.pri)
+
+QT += network
+
+TARGET = tst_updatechecker
+
+SOURCES += \
+    $$SRC_DIR/Utils/updatechecker.cpp \
+    tst_updatechecker.cpp
+
+HEADERS += \
+    $$SRC_DIR/Utils/updatechecker.h